@@ -0,0 +1,309 @@
+// pepper_bench - renders synthetic scenes for a fixed number of frames or a
+// fixed duration and reports frame time statistics as JSON
+
+#include "context.hpp"
+#include "scene.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct bench_settings
+    {
+        uint64_t frames = 1000;
+        double seconds = 0.0;     // overrides frames when non-zero
+        uint64_t warmup = 60;
+
+        uint32_t quads = 1;
+        uint32_t draws = 1;
+        uint32_t pipelines = 1;
+
+        std::string output;       // stdout when empty
+
+        ppr::context_config context;
+    };
+
+    struct summary
+    {
+        double mean = 0.0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        double min = 0.0;
+        double max = 0.0;
+    };
+
+    void print_usage()
+    {
+        std::cerr << "usage: pepper_bench [options]\n"
+                     "  --frames N            frames to measure (default 1000)\n"
+                     "  --seconds S           measure for S seconds instead of a frame count\n"
+                     "  --warmup N            unmeasured frames before measuring (default 60)\n"
+                     "  --quads N             quads in the scene (default 1)\n"
+                     "  --draws N             draw calls the quads are split over (default 1)\n"
+                     "  --pipelines M         pipelines the draw calls alternate between (default 1)\n"
+                     "  --width W --height H  render extent (default 800x600)\n"
+                     "  --frames-in-flight N  (default 2)\n"
+                     "  --record-threads N    threads recording draws, 0 for the cores compiling leaves (default 0)\n"
+                     "  --compile-threads N   threads creating pipelines, 0 for the cores recording leaves (default 0)\n"
+                     "  --windowed            render to a window instead of offscreen images\n"
+                     "  --out FILE            write the JSON report to FILE instead of stdout\n";
+    }
+
+    bool parse_args(int argc, char** argv, bench_settings& a_settings)
+    {
+        a_settings.context.headless = true;
+        a_settings.context.hot_reload = false; // no background rebuilds during measurement
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+
+            if (arg == "--windowed")
+            {
+                a_settings.context.headless = false;
+                continue;
+            }
+
+            if (i + 1 >= argc)
+                return false;
+
+            const char* value = argv[++i];
+
+            if (arg == "--frames")
+                a_settings.frames = std::strtoull(value, nullptr, 10);
+            else if (arg == "--seconds")
+                a_settings.seconds = std::strtod(value, nullptr);
+            else if (arg == "--warmup")
+                a_settings.warmup = std::strtoull(value, nullptr, 10);
+            else if (arg == "--quads")
+                a_settings.quads = std::strtoul(value, nullptr, 10);
+            else if (arg == "--draws")
+                a_settings.draws = std::strtoul(value, nullptr, 10);
+            else if (arg == "--pipelines")
+                a_settings.pipelines = std::strtoul(value, nullptr, 10);
+            else if (arg == "--width")
+                a_settings.context.extent.width = std::strtoul(value, nullptr, 10);
+            else if (arg == "--height")
+                a_settings.context.extent.height = std::strtoul(value, nullptr, 10);
+            else if (arg == "--frames-in-flight")
+                a_settings.context.frames_in_flight = std::strtoul(value, nullptr, 10);
+            else if (arg == "--record-threads")
+                a_settings.context.record_threads = std::strtoul(value, nullptr, 10);
+            else if (arg == "--compile-threads")
+                a_settings.context.compile_threads = std::strtoul(value, nullptr, 10);
+            else if (arg == "--out")
+                a_settings.output = value;
+            else
+                return false;
+        }
+
+        a_settings.quads = std::max(1u, a_settings.quads);
+        a_settings.draws = std::max(1u, std::min(a_settings.draws, a_settings.quads));
+        a_settings.pipelines = std::max(1u, a_settings.pipelines);
+
+        return a_settings.context.frames_in_flight > 0;
+    }
+
+    // Lays the quads out on a square grid covering the viewport and splits
+    // them into contiguous draw calls, alternating between pipelines
+    ppr::scene build_scene(const bench_settings& a_settings)
+    {
+        ppr::scene scene;
+
+        // Identical descriptions would be deduplicated into one pipeline, so each one
+        // gets its own brightness constant. All of them share the same shader modules.
+        for (uint32_t i = 0; i < a_settings.pipelines; ++i)
+        {
+            ppr::pipeline_description description;
+            description.specialization.push_back(ppr::specialization_constant::from_float(0, 1.f - 0.5f * i / a_settings.pipelines));
+            scene.pipelines.push_back(description);
+        }
+
+        const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(a_settings.quads))));
+        const float cell = 2.f / side;
+        const float half_extent = cell * 0.4f;
+
+        scene.vertices.reserve(a_settings.quads * 4);
+        scene.indices.reserve(a_settings.quads * 6);
+
+        for (uint32_t i = 0; i < a_settings.quads; ++i)
+        {
+            const float x = -1.f + cell * (i % side + 0.5f);
+            const float y = -1.f + cell * (i / side + 0.5f);
+            const glm::vec3 color(static_cast<float>(i % 7) / 6.f, 
+                                  static_cast<float>(i % 5) / 4.f, 
+                                  static_cast<float>(i % 3) / 2.f);
+
+            scene.vertices.emplace_back(glm::vec2(x - half_extent, y - half_extent), color);
+            scene.vertices.emplace_back(glm::vec2(x + half_extent, y - half_extent), color);
+            scene.vertices.emplace_back(glm::vec2(x + half_extent, y + half_extent), color);
+            scene.vertices.emplace_back(glm::vec2(x - half_extent, y + half_extent), color);
+
+            const uint32_t base = i * 4;
+            for (uint32_t i_index : { 0u, 1u, 2u, 2u, 3u, 0u })
+                scene.indices.push_back(base + i_index);
+        }
+
+        for (uint32_t i = 0; i < a_settings.draws; ++i)
+        {
+            const uint32_t first_quad = static_cast<uint32_t>(uint64_t(a_settings.quads) * i / a_settings.draws);
+            const uint32_t last_quad = static_cast<uint32_t>(uint64_t(a_settings.quads) * (i + 1) / a_settings.draws);
+
+            scene.draws.push_back({ (last_quad - first_quad) * 6, first_quad * 6, 0, i % a_settings.pipelines });
+        }
+
+        return scene;
+    }
+
+    // nearest-rank percentile over sorted samples
+    double percentile(const std::vector<double>& a_sorted, double a_percent)
+    {
+        const size_t rank = static_cast<size_t>(std::ceil(a_percent / 100.0 * a_sorted.size()));
+        return a_sorted[std::min(a_sorted.size() - 1, rank == 0 ? 0 : rank - 1)];
+    }
+
+    summary summarize(std::vector<double> a_samples)
+    {
+        summary result;
+
+        if (a_samples.empty())
+            return result;
+
+        std::sort(a_samples.begin(), a_samples.end());
+
+        double total = 0.0;
+        for (double i_sample : a_samples)
+            total += i_sample;
+
+        result.mean = total / a_samples.size();
+        result.p50  = percentile(a_samples, 50.0);
+        result.p95  = percentile(a_samples, 95.0);
+        result.p99  = percentile(a_samples, 99.0);
+        result.min  = a_samples.front();
+        result.max  = a_samples.back();
+
+        return result;
+    }
+
+    void write_summary(std::ostream& a_out, const summary& a_summary)
+    {
+        a_out << "{ \"mean\": " << a_summary.mean
+              << ", \"p50\": "  << a_summary.p50
+              << ", \"p95\": "  << a_summary.p95
+              << ", \"p99\": "  << a_summary.p99
+              << ", \"min\": "  << a_summary.min
+              << ", \"max\": "  << a_summary.max << " }";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    using clock = std::chrono::steady_clock;
+    using milliseconds = std::chrono::duration<double, std::milli>;
+
+    bench_settings settings;
+    if (!parse_args(argc, argv, settings))
+    {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    std::vector<double> cpu_times;
+    std::vector<double> gpu_times;
+    double measured_seconds = 0.0;
+
+    {
+        ppr::context context("pepper_bench", settings.context);
+        if (!context.load_scene(build_scene(settings)))
+            return EXIT_FAILURE;
+
+        for (uint64_t i = 0; i < settings.warmup; ++i)
+            context.draw_frame();
+
+        const uint64_t first_measured_frame = settings.warmup;
+        uint64_t last_gpu_frame = UINT64_MAX;
+
+        cpu_times.reserve(settings.seconds > 0.0 ? 4096 : settings.frames);
+        gpu_times.reserve(cpu_times.capacity());
+
+        const auto start = clock::now();
+        auto frame_start = start;
+
+        for (uint64_t frame = 0;; ++frame)
+        {
+            if (settings.seconds > 0.0)
+            {
+                if (std::chrono::duration<double>(frame_start - start).count() >= settings.seconds)
+                    break;
+            }
+            else if (frame >= settings.frames)
+                break;
+
+            context.draw_frame();
+
+            const auto frame_end = clock::now();
+            cpu_times.push_back(milliseconds(frame_end - frame_start).count());
+            frame_start = frame_end;
+
+            // GPU times arrive once a frame retires, a few frames behind the CPU
+            const ppr::profiler_report& report = context.frame_report();
+            if (report.valid && report.frame_number != last_gpu_frame && report.frame_number >= first_measured_frame)
+            {
+                last_gpu_frame = report.frame_number;
+                gpu_times.push_back(report.milliseconds("frame"));
+            }
+        }
+
+        measured_seconds = std::chrono::duration<double>(frame_start - start).count();
+    }
+
+    std::ofstream file;
+    if (!settings.output.empty())
+    {
+        file.open(settings.output);
+        if (!file.is_open())
+        {
+            std::cerr << "Failed to open " << settings.output << " for writing.\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::ostream& out = settings.output.empty() ? std::cout : file;
+
+    out << "{\n"
+        << "  \"scene\": { \"quads\": " << settings.quads
+        << ", \"draws\": " << settings.draws
+        << ", \"pipelines\": " << settings.pipelines << " },\n"
+        << "  \"config\": { \"width\": " << settings.context.extent.width
+        << ", \"height\": " << settings.context.extent.height
+        << ", \"frames_in_flight\": " << settings.context.frames_in_flight
+        << ", \"record_threads\": " << settings.context.record_threads
+        << ", \"compile_threads\": " << settings.context.compile_threads
+        << ", \"headless\": " << (settings.context.headless ? "true" : "false")
+        << ", \"warmup\": " << settings.warmup << " },\n"
+        << "  \"frames\": " << cpu_times.size() << ",\n"
+        << "  \"seconds\": " << measured_seconds << ",\n"
+        << "  \"fps\": " << (measured_seconds > 0.0 ? cpu_times.size() / measured_seconds : 0.0) << ",\n"
+        << "  \"cpu_frame_ms\": ";
+    write_summary(out, summarize(cpu_times));
+    out << ",\n  \"gpu_frame_ms\": ";
+
+    if (gpu_times.empty())
+        out << "null";
+    else
+        write_summary(out, summarize(gpu_times));
+
+    out << "\n}\n";
+
+    return EXIT_SUCCESS;
+}
@@ -1,2 +0,0 @@
-%~dp0/../Common/Bin/glslangValidator.exe -V shader.vert
-%~dp0/../Common/Bin/glslangValidator.exe -V shader.frag
\ No newline at end of file
@@ -4,7 +4,9 @@
 layout(location = 0) in vec3 frag_color;
 layout(location = 0) out vec4 out_color;
 
+layout(constant_id = 0) const float BRIGHTNESS = 1.0;
+
 void main()
 {
-    out_color = vec4(frag_color, 1.0);
+    out_color = vec4(frag_color * BRIGHTNESS, 1.0);
 }
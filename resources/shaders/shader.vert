@@ -1,12 +1,15 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(binding = 0) uniform uniform_buffer_object
+layout(binding = 0) uniform frame_uniforms
+{
+    mat4 view_projection;
+} frame;
+
+layout(binding = 1) uniform draw_uniforms
 {
     mat4 model;
-    mat4 view;
-    mat4 projection;
-} ubo;
+} draw;
 
 layout(location = 0) in vec2 in_position;
 layout(location = 1) in vec3 in_color;
@@ -18,9 +21,8 @@ out gl_PerVertex
 
 void main() 
 {
-    gl_Position = ubo.projection 
-                * ubo.view 
-                * ubo.model
+    gl_Position = frame.view_projection 
+                * draw.model
                 * vec4(in_position, 0.0, 1.0);
     frag_color = in_color;
 }
\ No newline at end of file
@@ -0,0 +1,5 @@
+@echo off
+rem Compiles the GLSL sources next to themselves for builds without shaderc
+for %%f in ("%~dp0..\resources\shaders\*.vert" "%~dp0..\resources\shaders\*.frag") do (
+    "%VULKAN_SDK%\Bin\glslc.exe" --target-env=vulkan1.1 -O "%%f" -o "%%f.spv" || exit /b 1
+)
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "memory_allocator.hpp"
+#include "deletion_queue.hpp"
+
 #include <vulkan/vulkan.hpp>
 namespace ppr
 {
@@ -7,68 +10,48 @@ namespace ppr
     {
     public:
         struct create_info;
-        struct copy_data;
 
-        buffer(const vk::Device& a_device);
+        buffer(const vk::Device& a_device, memory_allocator& an_allocator);
 
-        void create(const vk::PhysicalDevice& a_physical_device,
-                    const vk::BufferCreateInfo a_buffer_info,
+        void create(const vk::BufferCreateInfo a_buffer_info,
                     const vk::MemoryPropertyFlags a_properties);
 
         void create(const create_info a_create_info);
 
-        uint32_t find_memory_type(const     uint32_t a_typefilter,
-                                        vk::MemoryPropertyFlags a_properties,
-                                  const vk::PhysicalDevice& a_physical_device) const;
+        // Creates the buffer in memory_allocator::DIRECT_WRITE_PROPERTIES memory if the
+        // allocator supports it for this buffer, otherwise returns false and stays empty
+        bool try_create_direct_write(const vk::BufferCreateInfo a_buffer_info);
 
         vk::Buffer& get_mut();
         const vk::Buffer& get() const;
         const vk::DeviceMemory& memory() const;
+        const allocation& memory_range() const;
 
-        void copy(const copy_data& a_buffer_data) const;
+        // Host pointer to the start of the buffer, null unless created host visible
+        void* mapped() const;
 
-        void destroy() const;
+        void destroy();
+        // Hands the buffer and its memory to a_deletions, leaving this object empty
+        void destroy(deletion_queue& a_deletions);
 
     private:
         const vk::Device& m_device;
+        memory_allocator& m_allocator;
         
         vk::Buffer m_buffer;
-        vk::DeviceMemory m_buffer_memory;
+        allocation m_allocation;
 
     public:
-        struct copy_data
-        {
-            copy_data(const     buffer& a_dst,
-                      const vk::Device* const a_device,
-                      const vk::DeviceSize& a_size,
-                      const vk::CommandPool& a_pool,
-                      const vk::Queue& a_queue)
-                : dst_buffer(a_dst.get())
-                , device(a_device)
-                , size(a_size)
-                , cmd_pool(a_pool)
-                , queue(a_queue)
-            {}
-
-            const vk::Buffer& dst_buffer;
-            const vk::Device* const device;
-            const vk::DeviceSize& size;
-            const vk::CommandPool& cmd_pool;
-            const vk::Queue& queue;
-        };
-
         struct create_info
         {
-            create_info(const vk::PhysicalDevice& a_physical_device,
-                        const vk::MemoryPropertyFlags a_mem_properties,
+            create_info(const vk::MemoryPropertyFlags a_mem_properties,
                         const vk::BufferUsageFlags a_usage = vk::BufferUsageFlags(),
                         const vk::DeviceSize a_size = 0,
                         const vk::BufferCreateFlags a_buffer_create_flags = vk::BufferCreateFlags(),
                         const vk::SharingMode a_sharing_mode = vk::SharingMode::eExclusive,
                         const uint32_t a_queue_index_count = 0,
                         const uint32_t* const a_queue_indices = nullptr)
-                : device(a_physical_device)
-                , data(a_buffer_create_flags,
+                : data(a_buffer_create_flags,
                     a_size,
                     a_usage,
                     a_sharing_mode,
@@ -77,15 +60,12 @@ namespace ppr
                 , mem_properties(a_mem_properties)
             {}
 
-            create_info(const vk::PhysicalDevice& a_physical_device,
-                        const vk::MemoryPropertyFlags a_mem_properties,
+            create_info(const vk::MemoryPropertyFlags a_mem_properties,
                         const vk::BufferCreateInfo a_create_info = vk::BufferCreateInfo())
-                : device(a_physical_device)
-                , data(a_create_info)
+                : data(a_create_info)
                 , mem_properties(a_mem_properties)
             {}
 
-            const vk::PhysicalDevice& device;
             const vk::BufferCreateInfo data;
             const vk::MemoryPropertyFlags mem_properties;
         };
@@ -0,0 +1,78 @@
+#include "command_allocator.hpp"
+#include "logger.hpp"
+
+namespace ppr
+{
+    command_allocator::command_allocator(const vk::Device& a_device)
+        : m_device(a_device)
+        , m_thread_count(0)
+        , m_frame_index(0)
+    {}
+
+    void command_allocator::init(uint32_t a_frames_in_flight, uint32_t a_thread_count, uint32_t a_queue_family)
+    {
+        log->trace("Creating command pools...");
+
+        m_thread_count = a_thread_count;
+
+        // Buffers are only ever reset together with their pool
+        const vk::CommandPoolCreateInfo pool_info(vk::CommandPoolCreateFlagBits::eTransient, a_queue_family);
+
+        m_pools.resize(a_frames_in_flight);
+
+        for (auto& i_frame : m_pools)
+        {
+            i_frame.resize(m_thread_count);
+
+            for (auto& i_pool : i_frame)
+                i_pool.pool = m_device.createCommandPool(pool_info);
+        }
+
+        log->trace("Created {} command pools for {} threads.", a_frames_in_flight * m_thread_count, m_thread_count);
+    }
+
+    void command_allocator::destroy()
+    {
+        // destroying a pool frees its command buffers
+        for (const auto& i_frame : m_pools)
+            for (const auto& i_pool : i_frame)
+                m_device.destroyCommandPool(i_pool.pool);
+
+        m_pools.clear();
+    }
+
+    void command_allocator::begin_frame(uint32_t a_frame_index)
+    {
+        m_frame_index = a_frame_index;
+
+        for (auto& i_pool : m_pools[m_frame_index])
+        {
+            if (i_pool.primaries.used == 0 && i_pool.secondaries.used == 0)
+                continue;
+
+            m_device.resetCommandPool(i_pool.pool, vk::CommandPoolResetFlags());
+
+            i_pool.primaries.used = 0;
+            i_pool.secondaries.used = 0;
+        }
+    }
+
+    vk::CommandBuffer command_allocator::allocate(uint32_t a_thread_index, vk::CommandBufferLevel a_level)
+    {
+        thread_pool& pool = m_pools[m_frame_index][a_thread_index];
+        recycled_buffers& recycled = a_level == vk::CommandBufferLevel::ePrimary ? pool.primaries : pool.secondaries;
+
+        if (recycled.used == recycled.buffers.size())
+        {
+            const vk::CommandBufferAllocateInfo alloc_info(pool.pool, a_level, 1);
+            recycled.buffers.push_back(m_device.allocateCommandBuffers(alloc_info).front());
+        }
+
+        return recycled.buffers[recycled.used++];
+    }
+
+    uint32_t command_allocator::thread_count() const
+    {
+        return m_thread_count;
+    }
+}
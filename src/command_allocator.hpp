@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <vector>
+
+namespace ppr
+{
+    // Command buffers for per-frame recording. Every recording thread owns one
+    // command pool per frame in flight, so allocating never needs a lock. Buffers
+    // are never freed or reset one by one. A frame slot's pools are reset
+    // wholesale when the slot comes around again, and the buffers they hold are
+    // handed out again in the next frame.
+    class command_allocator
+    {
+    public:
+        explicit command_allocator(const vk::Device& a_device);
+
+        void init(uint32_t a_frames_in_flight, uint32_t a_thread_count, uint32_t a_queue_family);
+        void destroy();
+
+        // The caller must have waited for the previous submission of this frame slot
+        void begin_frame(uint32_t a_frame_index);
+
+        // Returns a reset buffer, valid until the frame slot comes around again.
+        // Only ever called from the thread a_thread_index stands for.
+        vk::CommandBuffer allocate(uint32_t a_thread_index, vk::CommandBufferLevel a_level);
+
+        uint32_t thread_count() const;
+
+    private:
+        struct recycled_buffers
+        {
+            std::vector<vk::CommandBuffer> buffers;
+            size_t used = 0;
+        };
+
+        struct thread_pool
+        {
+            vk::CommandPool pool;
+            recycled_buffers primaries;
+            recycled_buffers secondaries;
+        };
+
+    private:
+        const vk::Device& m_device;
+
+        uint32_t m_thread_count;
+        uint32_t m_frame_index;
+        std::vector<std::vector<thread_pool>> m_pools; // [frame][thread]
+    };
+}
@@ -0,0 +1,146 @@
+#include "command_recorder.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+
+namespace ppr
+{
+    constexpr size_t command_recorder::MIN_ITEMS_PER_THREAD;
+
+    command_recorder::command_recorder(command_allocator& a_commands, uint32_t a_thread_count)
+        : m_commands(a_commands)
+        , m_thread_count(a_thread_count)
+        , m_count(0)
+        , m_chunks(0)
+        , m_inheritance(nullptr)
+        , m_record(nullptr)
+        , m_job(0)
+        , m_remaining(0)
+        , m_stopping(false)
+    {
+        if (m_thread_count == 0)
+            m_thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    command_recorder::~command_recorder()
+    {
+        destroy();
+    }
+
+    void command_recorder::init()
+    {
+        if (m_commands.thread_count() < m_thread_count)
+            log->critical("Command allocator has pools for {} threads, recording needs {}.", 
+                          m_commands.thread_count(), m_thread_count);
+
+        m_stopping = false;
+
+        // Workers start from the current job, one handed out before they first lock is still theirs
+        for (uint32_t i = 1; i < m_thread_count; ++i)
+            m_threads.emplace_back(&command_recorder::work, this, i, m_job);
+
+        log->debug("Recording draws on up to {} threads.", m_thread_count);
+    }
+
+    void command_recorder::destroy()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+
+        m_job_available.notify_all();
+
+        for (auto& i_thread : m_threads)
+            i_thread.join();
+
+        m_threads.clear();
+        m_recorded.clear();
+    }
+
+    uint32_t command_recorder::chunk_count(size_t a_count) const
+    {
+        const size_t chunks = std::min<size_t>(m_thread_count, a_count / MIN_ITEMS_PER_THREAD);
+        return static_cast<uint32_t>(std::max<size_t>(1, chunks));
+    }
+
+    const std::vector<vk::CommandBuffer>& command_recorder::record(size_t a_count,
+                                                                   const vk::CommandBufferInheritanceInfo& an_inheritance,
+                                                                   const record_function& a_record)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_count = a_count;
+            m_chunks = chunk_count(a_count);
+            m_inheritance = &an_inheritance;
+            m_record = &a_record;
+            m_recorded.assign(m_chunks, vk::CommandBuffer());
+
+            m_remaining = m_chunks - 1;
+            ++m_job;
+        }
+
+        if (m_chunks > 1)
+            m_job_available.notify_all();
+
+        record_chunk(0);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_job_done.wait(lock, [this]() { return m_remaining == 0; });
+
+        m_inheritance = nullptr;
+        m_record = nullptr;
+
+        return m_recorded;
+    }
+
+    uint32_t command_recorder::thread_count() const
+    {
+        return m_thread_count;
+    }
+
+    void command_recorder::work(uint32_t a_thread_index, uint64_t a_seen_job)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        uint64_t seen_job = a_seen_job;
+
+        while (true)
+        {
+            m_job_available.wait(lock, [this, seen_job]() { return m_stopping || m_job != seen_job; });
+
+            if (m_stopping)
+                return;
+
+            seen_job = m_job;
+
+            // fewer chunks than threads, this one sits the job out
+            if (a_thread_index >= m_chunks)
+                continue;
+
+            lock.unlock();
+            record_chunk(a_thread_index);
+            lock.lock();
+
+            if (--m_remaining == 0)
+                m_job_done.notify_one();
+        }
+    }
+
+    void command_recorder::record_chunk(uint32_t a_thread_index)
+    {
+        const size_t begin = m_count * a_thread_index / m_chunks;
+        const size_t end = m_count * (a_thread_index + 1) / m_chunks;
+
+        const vk::CommandBuffer cmd = m_commands.allocate(a_thread_index, vk::CommandBufferLevel::eSecondary);
+
+        const vk::CommandBufferBeginInfo begin_info(vk::CommandBufferUsageFlagBits::eRenderPassContinue
+                                                  | vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+                                                    m_inheritance);
+        cmd.begin(begin_info);
+        (*m_record)(cmd, begin, end);
+        cmd.end();
+
+        m_recorded[a_thread_index] = cmd;
+    }
+}
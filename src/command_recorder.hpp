@@ -0,0 +1,76 @@
+#pragma once
+
+#include "command_allocator.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ppr
+{
+    // Records a frame's draws into secondary command buffers on several threads.
+    // Thread i allocates from the command allocator's pools for thread i, the
+    // calling thread being thread 0, so no pool is ever touched by two threads.
+    class command_recorder
+    {
+    public:
+        // Records the items [a_begin, a_end) into a_commandbuffer, which is already begun
+        using record_function = std::function<void(const vk::CommandBuffer& a_commandbuffer, size_t a_begin, size_t a_end)>;
+
+        // 0 uses one thread per core, counting the calling thread. a_commands must
+        // be initialized with at least thread_count() threads.
+        command_recorder(command_allocator& a_commands, uint32_t a_thread_count = 0);
+        ~command_recorder();
+
+        command_recorder(const command_recorder&) = delete;
+        command_recorder& operator=(const command_recorder&) = delete;
+
+        void init();
+        void destroy();
+
+        // How many secondaries record() splits a_count items into. Small counts
+        // stay on one thread, waking workers would cost more than it saves.
+        uint32_t chunk_count(size_t a_count) const;
+
+        // Splits the items into contiguous chunks, one per thread, and blocks until
+        // all are recorded. The returned buffers are in item order and stay valid
+        // until the next call.
+        const std::vector<vk::CommandBuffer>& record(size_t a_count,
+                                                     const vk::CommandBufferInheritanceInfo& an_inheritance,
+                                                     const record_function& a_record);
+
+        uint32_t thread_count() const;
+
+    public:
+        static constexpr size_t MIN_ITEMS_PER_THREAD = 256;
+
+    private:
+        void work(uint32_t a_thread_index, uint64_t a_seen_job);
+        void record_chunk(uint32_t a_thread_index);
+
+    private:
+        command_allocator& m_commands;
+
+        uint32_t m_thread_count;
+        std::vector<std::thread> m_threads; // workers 1..n-1, the caller records chunk 0
+
+        // The job of the current record() call, only written while no worker runs
+        size_t m_count;
+        uint32_t m_chunks;
+        const vk::CommandBufferInheritanceInfo* m_inheritance;
+        const record_function* m_record;
+        std::vector<vk::CommandBuffer> m_recorded;
+
+        uint64_t m_job;        // bumped to hand workers a new job
+        uint32_t m_remaining;  // workers still recording the current job
+        bool m_stopping;
+
+        std::mutex m_mutex;
+        std::condition_variable m_job_available;
+        std::condition_variable m_job_done;
+    };
+}
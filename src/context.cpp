@@ -8,20 +8,67 @@
 #include <set>
 #include <algorithm>
 #include <fstream>
+#include <thread>
 
 namespace ppr
 {
-	context::context(const std::string& a_title)
-		: m_window(a_title)
+    namespace
+    {
+        context_config with_thread_budget(context_config a_config)
+        {
+            const uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+
+            // the render thread records too, so recording gets the larger half
+            if (a_config.record_threads == 0 && a_config.compile_threads == 0)
+                a_config.record_threads = (cores + 1) / 2;
+
+            if (a_config.record_threads == 0)
+                a_config.record_threads = std::max(1u, cores - std::min(cores, a_config.compile_threads));
+
+            if (a_config.compile_threads == 0)
+                a_config.compile_threads = std::max(1u, cores - std::min(cores, a_config.record_threads));
+
+            return a_config;
+        }
+    }
+
+	context::context(const std::string& a_title, const context_config& a_config)
+		: m_config(with_thread_budget(a_config))
+		, m_window(a_title, a_config.extent.width, a_config.extent.height)
         , m_debugger(m_instance)
-		, m_swapchain(m_device, m_window, m_instance, m_physical_device)
+        , m_allocator(m_device, m_physical_device)
+        , m_pipeline_cache(m_device, m_physical_device)
+        , m_shader_compiler(SHADER_CACHE_DIR)
+        , m_shader_modules(m_device, m_shader_compiler)
+        , m_pipeline_compiler(m_config.compile_threads)
+        , m_pipeline_layouts(m_device)
+		, m_swapchain(m_device, m_window, m_instance, m_physical_device, 
+                      m_allocator, m_pipeline_cache, m_shader_modules, 
+                      m_pipeline_compiler, m_pipeline_layouts, m_config)
 	{
+        if (m_config.headless)
+            log->info("Running headless, rendering to offscreen images.");
+        else
+        {
+            m_window.init();
+            m_device_ext.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+        }
+
+        log->debug("{} threads record draws, {} create pipelines.", m_config.record_threads, m_config.compile_threads);
+
         log->info("Initializing Vulkan...");
         create_instance();
         m_debugger.init();
-        m_swapchain.create_window_surface();
+
+        if (!m_config.headless)
+            m_swapchain.create_window_surface();
+
         select_physical_device();
         create_device();
+        m_allocator.init();
+        m_pipeline_cache.init(PIPELINE_CACHE_PATH);
+        m_shader_compiler.init();
+        m_pipeline_compiler.init();
         m_swapchain.init();
         log->info("Vulkan initialized.\n");
     }
@@ -31,6 +78,12 @@ namespace ppr
         log->trace("Destroying context objects...");
 
         m_swapchain.destroy();
+        m_pipeline_compiler.destroy();
+        m_shader_modules.destroy();
+        m_pipeline_layouts.destroy();
+        m_pipeline_cache.save();
+        m_pipeline_cache.destroy();
+        m_allocator.destroy();
         m_device.destroy();
         m_debugger.destroy();
         m_instance.destroy();
@@ -38,21 +91,47 @@ namespace ppr
         log->info("Context successfully destroyed.");
     }
 
-	void context::run()
+	void context::run(uint64_t a_frame_limit)
 	{
-		main_loop();
+        if (m_config.headless && a_frame_limit == 0)
+        {
+            log->error("Headless context has no window to close, a frame limit is required.");
+            return;
+        }
+
+		main_loop(a_frame_limit);
 	}
 
+    void context::draw_frame()
+    {
+        if (!m_config.headless)
+            m_window.poll_events();
+
+        m_swapchain.draw();
+    }
+
+    bool context::load_scene(const scene& a_scene)
+    {
+        return m_swapchain.load_scene(a_scene);
+    }
+
+    const profiler_report& context::frame_report() const
+    {
+        return m_swapchain.frame_report();
+    }
+
     void context::init()
     {
     }
 
-    void context::main_loop()
+    void context::main_loop(uint64_t a_frame_limit)
     {
-        while (!m_window.should_close())
+        for (uint64_t frame = 0; a_frame_limit == 0 || frame < a_frame_limit; ++frame)
         {
-            m_window.poll_events();
-            m_swapchain.draw();
+            if (!m_config.headless && m_window.should_close())
+                break;
+
+            draw_frame();
         }
 
         m_device.waitIdle();
@@ -87,7 +166,8 @@ namespace ppr
 
         const std::vector<vk::ExtensionProperties> extension_properties = vk::enumerateInstanceExtensionProperties();
 
-        m_window.check_extension_compatibility(extensions, extension_properties);
+        if (!m_config.headless)
+            m_window.check_extension_compatibility(extensions, extension_properties);
 
         log->trace("Available extensions:");
         for (const auto& i_property : extension_properties)
@@ -109,8 +189,11 @@ namespace ppr
 
         const queue_families family_indices = m_swapchain.find_queue_families(m_physical_device);
 
+        if (family_indices.has_dedicated_transfer())
+            log->debug("Found dedicated transfer queue family {}.", family_indices.transfer);
+
         std::vector<vk::DeviceQueueCreateInfo> queue_create_infos;
-        const std::set<int> unique_families = { family_indices.graphics, family_indices.present };
+        const std::set<int> unique_families = { family_indices.graphics, family_indices.present, family_indices.transfer };
 
         const float queue_priority = 1.f;
         for (auto& i_family : unique_families)
@@ -142,6 +225,7 @@ namespace ppr
 
         m_swapchain.graphics_queue() = m_device.getQueue(family_indices.graphics, 0);
         m_swapchain.present_queue() = m_device.getQueue(family_indices.present, 0);
+        m_swapchain.transfer_queue() = m_device.getQueue(family_indices.transfer, 0);
 
         log->debug("Successfully created logical Vulkan Device.");
     }
@@ -177,9 +261,9 @@ namespace ppr
         const queue_families family_indices = m_swapchain.find_queue_families(a_device);
 
         const bool is_ext_supported = check_ext_support(a_device);
-		bool is_swapchain_adequate = false;
+		bool is_swapchain_adequate = m_config.headless;
 
-		if (is_ext_supported)
+		if (is_ext_supported && !m_config.headless)
 		{
             const swapchain_support support_details = m_swapchain.query_support(a_device);
 			is_swapchain_adequate = !support_details.formats.empty() && !support_details.present_modes.empty();
@@ -192,7 +276,10 @@ namespace ppr
 	{
 		log->trace("Fetching required extensions...");
 
-		std::vector<const char*> extensions = m_window.required_extensions();
+		std::vector<const char*> extensions;
+
+		if (!m_config.headless)
+			extensions = m_window.required_extensions();
 
 		if (VALIDATION_LAYERS_ENABLED)
 			extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -19,14 +19,26 @@ namespace ppr
 	class context
 	{
 	public:
-		context(const std::string& a_title = PROJECT_TITLE);
+		context(const std::string& a_title = PROJECT_TITLE, 
+                const context_config& a_config = context_config());
 		~context();
 
-		void run();
+		// Renders until the window closes, or for a_frame_limit frames if non-zero.
+		// Headless contexts have no window and always need a frame limit.
+		void run(uint64_t a_frame_limit = 0);
+
+		// Renders a single frame, for callers driving their own loop
+		void draw_frame();
+
+		// False if the scene was rejected, the previous one stays loaded
+		bool load_scene(const scene& a_scene);
+
+		// Per-scope GPU times of the most recently retired frame
+		const profiler_report& frame_report() const;
 
 	private:
 		void init();
-        void main_loop();
+        void main_loop(uint64_t a_frame_limit);
 
 		void create_instance();
 		void create_device();
@@ -39,9 +51,17 @@ namespace ppr
 		std::vector<const char*> required_extensions() const;
 
 	private:
+        const context_config m_config;
+
         // Pepper
         window m_window;
         debugger m_debugger;
+        memory_allocator m_allocator;
+        pipeline_cache m_pipeline_cache;
+        shader_compiler m_shader_compiler;
+        shader_module_cache m_shader_modules;
+        pipeline_compiler m_pipeline_compiler;
+        pipeline_layout_cache m_pipeline_layouts;
         swapchain m_swapchain;
 
 		// Vulkan
@@ -49,6 +69,6 @@ namespace ppr
 		vk::Device m_device;
 		vk::PhysicalDevice m_physical_device;
 
-		const std::vector<const char*> m_device_ext = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+		std::vector<const char*> m_device_ext;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "deletion_queue.hpp"
+#include "logger.hpp"
+
+namespace ppr
+{
+    deletion_queue::deletion_queue(const vk::Device& a_device, std::initializer_list<timeline*> a_timelines)
+        : m_device(a_device)
+        , m_timelines(a_timelines)
+    {}
+
+    void deletion_queue::push(std::function<void()> a_deleter)
+    {
+        entry new_entry;
+        new_entry.deleter = std::move(a_deleter);
+        new_entry.values.reserve(m_timelines.size());
+
+        for (auto i_timeline : m_timelines)
+            new_entry.values.push_back(i_timeline->pending_value());
+
+        m_entries.push_back(std::move(new_entry));
+    }
+
+    void deletion_queue::collect()
+    {
+        // Values never decrease, so the first entry still in use blocks everything behind it
+        while (!m_entries.empty() && has_retired(m_entries.front().values))
+        {
+            m_entries.front().deleter();
+            m_entries.pop_front();
+        }
+    }
+
+    void deletion_queue::flush()
+    {
+        if (m_entries.empty())
+            return;
+
+        log->trace("Flushing {} deferred deletions...", m_entries.size());
+
+        for (auto i_timeline : m_timelines)
+            i_timeline->wait_idle();
+
+        collect();
+    }
+
+    size_t deletion_queue::size() const
+    {
+        return m_entries.size();
+    }
+
+    bool deletion_queue::has_retired(const std::vector<uint64_t>& a_values) const
+    {
+        for (size_t i = 0; i < m_timelines.size(); ++i)
+        {
+            if (!m_timelines[i]->has_retired(a_values[i]))
+                return false;
+        }
+
+        return true;
+    }
+}
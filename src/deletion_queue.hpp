@@ -0,0 +1,60 @@
+#pragma once
+
+#include "timeline.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+namespace ppr
+{
+    // Defers destroying GPU objects until the work that may still use them has
+    // retired. Each entry records the pending value of every watched timeline at
+    // the time it is queued, so it outlives everything submitted before it on
+    // any queue, without waiting on the device.
+    class deletion_queue
+    {
+    public:
+        deletion_queue(const vk::Device& a_device, std::initializer_list<timeline*> a_timelines);
+
+        void push(std::function<void()> a_deleter);
+
+        template<typename T>
+        void destroy(T a_handle);
+
+        // Run every deleter whose work has retired, never blocks
+        void collect();
+        // Wait for all watched timelines and run everything, for shutdown
+        void flush();
+
+        size_t size() const;
+
+    private:
+        bool has_retired(const std::vector<uint64_t>& a_values) const;
+
+    private:
+        const vk::Device& m_device;
+        std::vector<timeline*> m_timelines;
+
+        struct entry
+        {
+            std::vector<uint64_t> values; // one per watched timeline
+            std::function<void()> deleter;
+        };
+
+        std::deque<entry> m_entries;
+    };
+
+    template<typename T>
+    void deletion_queue::destroy(T a_handle)
+    {
+        if (!a_handle)
+            return;
+
+        const vk::Device& device = m_device;
+        push([&device, a_handle]() { device.destroy(a_handle); });
+    }
+}
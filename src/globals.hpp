@@ -1,9 +1,21 @@
 #pragma once
 
+#include <cstdint>
+
 namespace ppr
 {
 	constexpr const char* LNG_STANDARD_VALIDATION_NAME = "VK_LAYER_LUNARG_standard_validation";
     constexpr const char* PROJECT_TITLE = "pepper";
+
+    // How many frames the CPU may record ahead of the GPU
+    constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+
+    constexpr const char* PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+    constexpr const char* PIPELINE_USAGE_PATH = "pipeline_usage.bin";
+
+    // GLSL sources ship in resources/shaders, compiled SPIR-V is cached next to the executable
+    constexpr const char* SHADER_DIR = "shaders/";
+    constexpr const char* SHADER_CACHE_DIR = "shader_cache";
 }
 
 namespace ppr
@@ -11,8 +23,10 @@ namespace ppr
 
 #ifdef PPR_DEBUG
 	constexpr bool VALIDATION_LAYERS_ENABLED = true;
+	constexpr bool SHADER_HOT_RELOAD_DEFAULT = true;
 #else
 	constexpr bool VALIDATION_LAYERS_ENABLED = false;
+	constexpr bool SHADER_HOT_RELOAD_DEFAULT = false;
 #endif
 
 }
\ No newline at end of file
@@ -2,52 +2,50 @@
 
 namespace ppr
 {
-    index_buffer::index_buffer(const vk::Device& a_device)
+    index_buffer::index_buffer(const vk::Device& a_device, memory_allocator& an_allocator)
         : m_device(a_device)
-        , m_buffer(a_device)
+        , m_buffer(a_device, an_allocator)
         , m_indices({0, 1, 2, 2, 3, 0})
     {}
 
-    void index_buffer::create(const vk::PhysicalDevice& a_physical_device,
-                              const vk::CommandPool& a_command_pool,
-                              const vk::Queue& a_graphics_queue)
+    upload_ticket index_buffer::create(upload_batcher& a_uploads)
     {
         const vk::DeviceSize buffer_size = sizeof(m_indices[0]) * m_indices.size();
 
-        buffer staging_buffer(m_device);
-        auto staging_buffer_info = buffer::create_info(a_physical_device,
-                                                       vk::MemoryPropertyFlagBits::eHostVisible
-                                                       | vk::MemoryPropertyFlagBits::eHostCoherent,
-                                                       vk::BufferUsageFlagBits::eTransferSrc,
-                                                       buffer_size);
-        staging_buffer.create(staging_buffer_info);
+        // UMA and ReBAR memory is written in place, skipping the staging copy altogether
+        if (m_buffer.try_create_direct_write(vk::BufferCreateInfo({}, buffer_size, vk::BufferUsageFlagBits::eIndexBuffer)))
+        {
+            memcpy(m_buffer.mapped(), m_indices.data(), buffer_size);
 
-        auto memory_map = m_device.mapMemory(staging_buffer.memory(), 0, staging_buffer_info.data.size);
-        memcpy(memory_map, m_indices.data(), staging_buffer_info.data.size);
-        m_device.unmapMemory(staging_buffer.memory());
+            // host writes before the next submission are visible to it, nothing to wait on
+            return upload_ticket();
+        }
 
-        auto index_buffer_info = buffer::create_info(a_physical_device,
-                                                      vk::MemoryPropertyFlagBits::eDeviceLocal,
+        auto index_buffer_info = buffer::create_info(vk::MemoryPropertyFlagBits::eDeviceLocal,
                                                       vk::BufferUsageFlagBits::eTransferDst
                                                       | vk::BufferUsageFlagBits::eIndexBuffer,
                                                       buffer_size);
         m_buffer.create(index_buffer_info);
 
-        auto buffer_copy_data = buffer::copy_data(m_buffer,
-                                                  nullptr,
-                                                  buffer_size,
-                                                  a_command_pool,
-                                                  a_graphics_queue);
-        staging_buffer.copy(buffer_copy_data);
-
-        staging_buffer.destroy();
+        // lands in the next upload batch, submitted ahead of the frame that draws with it
+        return a_uploads.enqueue(m_buffer, m_indices.data(), buffer_size);
     }
 
-    void index_buffer::destroy() const
+    void index_buffer::destroy()
     {
         m_buffer.destroy();
     }
 
+    void index_buffer::destroy(deletion_queue& a_deletions)
+    {
+        m_buffer.destroy(a_deletions);
+    }
+
+    void index_buffer::set_indices(const std::vector<uint32_t>& a_indices)
+    {
+        m_indices = a_indices;
+    }
+
     const vk::Buffer& index_buffer::get() const
     {
         return m_buffer.get();
@@ -58,7 +56,7 @@ namespace ppr
         return m_buffer.get_mut();
     }
 
-    const std::vector<uint16_t>& index_buffer::indices() const
+    const std::vector<uint32_t>& index_buffer::indices() const
     {
         return m_indices;
     }
@@ -1,5 +1,6 @@
 #pragma once
 #include "buffer.hpp"
+#include "upload_batcher.hpp"
 
 #include <vector>
 
@@ -8,21 +9,22 @@ namespace ppr
     class index_buffer
     {
     public:
-        explicit index_buffer(const vk::Device& a_device);
+        index_buffer(const vk::Device& a_device, memory_allocator& an_allocator);
 
-		void create(const vk::PhysicalDevice& a_physical_device,
-                    const vk::CommandPool& a_command_pool,
-                    const vk::Queue& a_graphics_queue);
-        void destroy() const;
+		upload_ticket create(upload_batcher& a_uploads);
+        void destroy();
+        void destroy(deletion_queue& a_deletions);
+
+        void set_indices(const std::vector<uint32_t>& a_indices);
 
         vk::Buffer& get_mut();
         const vk::Buffer& get() const;
 
-        const std::vector<uint16_t>& indices() const;
+        const std::vector<uint32_t>& indices() const;
 
     private:
         const vk::Device& m_device;
-        const std::vector<uint16_t> m_indices;
+        std::vector<uint32_t> m_indices;
 
         buffer m_buffer;
     };
@@ -22,7 +22,7 @@ namespace ppr
     }
 
     logger::logger(log_level a_level)
-        : m_logger(spdlog::stderr_color_st("ppr"))
+        : m_logger(spdlog::stderr_color_mt("ppr"))
     {
         m_logger->set_pattern("%v");
         m_logger->set_level(spdlog::level::trace);
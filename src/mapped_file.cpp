@@ -0,0 +1,153 @@
+#include "mapped_file.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ppr
+{
+    mapped_file::mapped_file()
+        : m_data(nullptr)
+        , m_size(0)
+#ifdef _WIN32
+        , m_file(INVALID_HANDLE_VALUE)
+        , m_mapping(nullptr)
+#endif
+    {}
+
+    mapped_file::~mapped_file()
+    {
+        close();
+    }
+
+    mapped_file::mapped_file(mapped_file&& an_other)
+        : mapped_file()
+    {
+        *this = std::move(an_other);
+    }
+
+    mapped_file& mapped_file::operator=(mapped_file&& an_other)
+    {
+        if (this != &an_other)
+        {
+            close();
+
+            std::swap(m_data, an_other.m_data);
+            std::swap(m_size, an_other.m_size);
+#ifdef _WIN32
+            std::swap(m_file, an_other.m_file);
+            std::swap(m_mapping, an_other.m_mapping);
+#endif
+        }
+
+        return *this;
+    }
+
+#ifdef _WIN32
+    bool mapped_file::open(const std::string& a_path)
+    {
+        close();
+
+        m_file = CreateFileA(a_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, 
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+        LARGE_INTEGER size = {};
+        if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+        {
+            close();
+            return false;
+        }
+
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        m_data = m_mapping ? MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+        if (!m_data)
+        {
+            close();
+            return false;
+        }
+
+        m_size = static_cast<size_t>(size.QuadPart);
+        return true;
+    }
+
+    void mapped_file::close()
+    {
+        if (m_data)
+            UnmapViewOfFile(m_data);
+
+        if (m_mapping)
+            CloseHandle(m_mapping);
+
+        if (m_file != INVALID_HANDLE_VALUE)
+            CloseHandle(m_file);
+
+        m_data = nullptr;
+        m_size = 0;
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+    }
+#else
+    bool mapped_file::open(const std::string& a_path)
+    {
+        close();
+
+        const int fd = ::open(a_path.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+        // the mapping keeps the file referenced, the descriptor isn't needed anymore
+        ::close(fd);
+
+        if (data == MAP_FAILED)
+            return false;
+
+        m_data = data;
+        m_size = static_cast<size_t>(info.st_size);
+        return true;
+    }
+
+    void mapped_file::close()
+    {
+        if (m_data)
+            munmap(const_cast<void*>(m_data), m_size);
+
+        m_data = nullptr;
+        m_size = 0;
+    }
+#endif
+
+    const void* mapped_file::data() const
+    {
+        return m_data;
+    }
+
+    size_t mapped_file::size() const
+    {
+        return m_size;
+    }
+
+    bool mapped_file::is_open() const
+    {
+        return m_data != nullptr;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace ppr
+{
+    // Read-only memory mapping of a whole file. The contents are paged in by the
+    // OS on first touch instead of being copied into a heap buffer.
+    class mapped_file
+    {
+    public:
+        mapped_file();
+        ~mapped_file();
+
+        mapped_file(mapped_file&& an_other);
+        mapped_file& operator=(mapped_file&& an_other);
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        // Returns false for missing or empty files, neither can be mapped
+        bool open(const std::string& a_path);
+        void close();
+
+        const void* data() const;
+        size_t size() const;
+        bool is_open() const;
+
+    private:
+        const void* m_data;
+        size_t m_size;
+
+#ifdef _WIN32
+        void* m_file;
+        void* m_mapping;
+#endif
+    };
+}
@@ -0,0 +1,346 @@
+#include "memory_allocator.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+
+namespace ppr
+{
+    constexpr vk::DeviceSize memory_allocator::DEFAULT_BLOCK_SIZE;
+    constexpr vk::DeviceSize memory_allocator::SMALL_DIRECT_WRITE_SIZE;
+
+    const vk::MemoryPropertyFlags memory_allocator::DIRECT_WRITE_PROPERTIES = vk::MemoryPropertyFlagBits::eDeviceLocal
+                                                                            | vk::MemoryPropertyFlagBits::eHostVisible
+                                                                            | vk::MemoryPropertyFlagBits::eHostCoherent;
+
+    memory_allocator::memory_allocator(const vk::Device& a_device, const vk::PhysicalDevice& a_physical_device)
+        : m_device(a_device)
+        , m_physical_device(a_physical_device)
+        , m_max_allocations(0)
+        , m_direct_write(false)
+        , m_direct_write_unlimited(false)
+        , m_block_count(0)
+    {}
+
+    void memory_allocator::init()
+    {
+        log->trace("Initializing device memory allocator...");
+
+        m_memory_properties = m_physical_device.getMemoryProperties();
+        m_max_allocations = m_physical_device.getProperties().limits.maxMemoryAllocationCount;
+
+        for (uint32_t i = 0; i < m_memory_properties.memoryTypeCount; ++i)
+        {
+            const auto& type = m_memory_properties.memoryTypes[i];
+            log->trace("        memory type {}: heap {} ({} MiB), {}", i, type.heapIndex, 
+                       m_memory_properties.memoryHeaps[type.heapIndex].size / (1024 * 1024), 
+                       vk::to_string(type.propertyFlags));
+        }
+
+        vk::DeviceSize largest_local_heap = 0;
+        for (uint32_t i = 0; i < m_memory_properties.memoryHeapCount; ++i)
+        {
+            if (m_memory_properties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+                largest_local_heap = std::max(largest_local_heap, m_memory_properties.memoryHeaps[i].size);
+        }
+
+        for (uint32_t i = 0; i < m_memory_properties.memoryTypeCount; ++i)
+        {
+            const auto& type = m_memory_properties.memoryTypes[i];
+
+            if ((type.propertyFlags & DIRECT_WRITE_PROPERTIES) != DIRECT_WRITE_PROPERTIES)
+                continue;
+
+            m_direct_write = true;
+            m_direct_write_unlimited = m_direct_write_unlimited
+                                    || m_memory_properties.memoryHeaps[type.heapIndex].size >= largest_local_heap;
+        }
+
+        if (m_direct_write_unlimited)
+            log->info("Device local memory is host visible (UMA or ReBAR), uploads write it directly.");
+        else if (m_direct_write)
+            log->info("Small host-visible device-local heap found, small uploads write it directly.");
+
+        log->debug("Device memory allocator initialized.");
+    }
+
+    void memory_allocator::destroy()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (auto& i_pool : m_pools)
+        {
+            for (auto& i_block : i_pool.blocks)
+            {
+                if (i_block.used > 0)
+                    log->warn("Freeing memory block of type {} with {} bytes still allocated.", i_pool.memory_type, i_block.used);
+
+                m_device.freeMemory(i_block.memory);
+            }
+        }
+
+        m_pools.clear();
+        m_block_count = 0;
+    }
+
+    allocation memory_allocator::allocate(const vk::MemoryRequirements& a_requirements,
+                                                vk::MemoryPropertyFlags a_properties,
+                                                resource_kind a_kind)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const uint32_t memory_type = find_memory_type(a_requirements.memoryTypeBits, a_properties);
+        const uint32_t pool_index = find_pool(memory_type, a_kind);
+        pool& target = m_pools[pool_index];
+
+        vk::DeviceSize offset = 0;
+        block* chosen = nullptr;
+
+        for (auto& i_block : target.blocks)
+        {
+            if (suballocate(i_block, a_requirements, offset))
+            {
+                chosen = &i_block;
+                break;
+            }
+        }
+
+        if (chosen == nullptr)
+        {
+            chosen = &create_block(target, a_requirements.size);
+
+            if (!suballocate(*chosen, a_requirements, offset))
+                log->critical("Failed to sub-allocate {} bytes from a fresh memory block.", a_requirements.size);
+        }
+
+        allocation result;
+        result.memory = chosen->memory;
+        result.offset = offset;
+        result.size = a_requirements.size;
+        result.memory_type = memory_type;
+        result.pool = pool_index;
+
+        if (chosen->mapped != nullptr)
+            result.mapped = static_cast<char*>(chosen->mapped) + offset;
+
+        return result;
+    }
+
+    void memory_allocator::free(const allocation& an_allocation)
+    {
+        if (!an_allocation)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        pool& owner = m_pools[an_allocation.pool];
+
+        for (auto i_block = owner.blocks.begin(); i_block != owner.blocks.end(); ++i_block)
+        {
+            if (i_block->memory != an_allocation.memory)
+                continue;
+
+            release(*i_block, an_allocation.offset, an_allocation.size);
+
+            // Keep the last block of a pool around so alloc/free cycles don't hit the driver
+            if (i_block->used == 0 && owner.blocks.size() > 1)
+            {
+                m_device.freeMemory(i_block->memory);
+                owner.blocks.erase(i_block);
+                --m_block_count;
+            }
+
+            return;
+        }
+
+        log->error("Freed an allocation that does not belong to any memory block.");
+    }
+
+    allocation memory_allocator::allocate_buffer(const vk::Buffer& a_buffer, vk::MemoryPropertyFlags a_properties)
+    {
+        const allocation result = allocate(m_device.getBufferMemoryRequirements(a_buffer), 
+                                           a_properties, 
+                                           resource_kind::LINEAR);
+
+        m_device.bindBufferMemory(a_buffer, result.memory, result.offset);
+
+        return result;
+    }
+
+    allocation memory_allocator::allocate_image(const vk::Image& an_image, vk::MemoryPropertyFlags a_properties)
+    {
+        const allocation result = allocate(m_device.getImageMemoryRequirements(an_image), 
+                                           a_properties, 
+                                           resource_kind::OPTIMAL);
+
+        m_device.bindImageMemory(an_image, result.memory, result.offset);
+
+        return result;
+    }
+
+    uint32_t memory_allocator::find_memory_type(uint32_t a_typefilter, vk::MemoryPropertyFlags a_properties) const
+    {
+        int fallback = -1;
+
+        for (uint32_t i = 0; i < m_memory_properties.memoryTypeCount; ++i)
+        {
+            const auto flags = m_memory_properties.memoryTypes[i].propertyFlags;
+
+            // find index of suitable memory type by checking if the corresponding bit is set to 1
+            // also need to check if memory is suitable for writing to through property flags
+            if (!(a_typefilter & (1 << i)) || (flags & a_properties) != a_properties)
+                continue;
+
+            // Don't spend a scarce BAR window on allocations that never asked to be mapped
+            if (!(a_properties & vk::MemoryPropertyFlagBits::eHostVisible)
+              && (flags & vk::MemoryPropertyFlagBits::eHostVisible)
+              && (flags & vk::MemoryPropertyFlagBits::eDeviceLocal))
+            {
+                if (fallback < 0)
+                    fallback = static_cast<int>(i);
+                continue;
+            }
+
+            return i;
+        }
+
+        if (fallback >= 0)
+            return static_cast<uint32_t>(fallback);
+
+        log->critical("Failed to find suitable memory type.");
+        return 0;
+    }
+
+    bool memory_allocator::supports_direct_write(const vk::MemoryRequirements& a_requirements) const
+    {
+        if (!m_direct_write_unlimited 
+         && !(m_direct_write && a_requirements.size <= SMALL_DIRECT_WRITE_SIZE))
+            return false;
+
+        // The device having such a type doesn't mean this resource may live in it
+        for (uint32_t i = 0; i < m_memory_properties.memoryTypeCount; ++i)
+        {
+            const auto flags = m_memory_properties.memoryTypes[i].propertyFlags;
+
+            if ((a_requirements.memoryTypeBits & (1 << i)) && (flags & DIRECT_WRITE_PROPERTIES) == DIRECT_WRITE_PROPERTIES)
+                return true;
+        }
+
+        return false;
+    }
+
+    const vk::PhysicalDeviceMemoryProperties& memory_allocator::memory_properties() const
+    {
+        return m_memory_properties;
+    }
+
+    uint32_t memory_allocator::find_pool(uint32_t a_memory_type, resource_kind a_kind)
+    {
+        for (uint32_t i = 0; i < m_pools.size(); ++i)
+        {
+            if (m_pools[i].memory_type == a_memory_type && m_pools[i].kind == a_kind)
+                return i;
+        }
+
+        m_pools.push_back({ a_memory_type, a_kind, {} });
+
+        return static_cast<uint32_t>(m_pools.size() - 1);
+    }
+
+    memory_allocator::block& memory_allocator::create_block(pool& a_pool, vk::DeviceSize a_min_size)
+    {
+        if (m_block_count >= m_max_allocations)
+            log->critical("Reached maxMemoryAllocationCount ({}) for device memory blocks.", m_max_allocations);
+
+        // Oversized requests get a dedicated block of exactly their size
+        const vk::DeviceSize size = std::max(preferred_block_size(a_pool.memory_type), a_min_size);
+
+        block new_block;
+        new_block.size = size;
+        new_block.memory = m_device.allocateMemory(vk::MemoryAllocateInfo(size, a_pool.memory_type));
+        new_block.free_ranges.push_back({ 0, size });
+
+        const auto flags = m_memory_properties.memoryTypes[a_pool.memory_type].propertyFlags;
+        if (flags & vk::MemoryPropertyFlagBits::eHostVisible)
+            new_block.mapped = m_device.mapMemory(new_block.memory, 0, VK_WHOLE_SIZE);
+
+        ++m_block_count;
+        log->debug("Allocated {} KiB device memory block of type {} ({} blocks in total).", 
+                   size / 1024, a_pool.memory_type, m_block_count);
+
+        a_pool.blocks.push_back(std::move(new_block));
+        return a_pool.blocks.back();
+    }
+
+    bool memory_allocator::suballocate(block& a_block, const vk::MemoryRequirements& a_requirements, vk::DeviceSize& an_offset) const
+    {
+        const vk::DeviceSize alignment = std::max<vk::DeviceSize>(1, a_requirements.alignment);
+
+        // first fit
+        for (auto i_range = a_block.free_ranges.begin(); i_range != a_block.free_ranges.end(); ++i_range)
+        {
+            const vk::DeviceSize aligned = (i_range->offset + alignment - 1) / alignment * alignment;
+            const vk::DeviceSize padding = aligned - i_range->offset;
+
+            if (padding + a_requirements.size > i_range->size)
+                continue;
+
+            const free_range before = { i_range->offset, padding };
+            const free_range after = { aligned + a_requirements.size, i_range->size - padding - a_requirements.size };
+
+            i_range = a_block.free_ranges.erase(i_range);
+
+            if (after.size > 0)
+                i_range = a_block.free_ranges.insert(i_range, after);
+            if (before.size > 0)
+                a_block.free_ranges.insert(i_range, before);
+
+            // padding stays free and is recovered when neighbours are released
+            a_block.used += a_requirements.size;
+            an_offset = aligned;
+            return true;
+        }
+
+        return false;
+    }
+
+    void memory_allocator::release(block& a_block, vk::DeviceSize an_offset, vk::DeviceSize a_size) const
+    {
+        auto& ranges = a_block.free_ranges;
+
+        auto next = std::lower_bound(ranges.begin(), ranges.end(), an_offset,
+                                     [](const free_range& a_range, vk::DeviceSize a_offset)
+                                     { return a_range.offset < a_offset; });
+
+        next = ranges.insert(next, { an_offset, a_size });
+
+        // merge with the following range
+        auto following = next + 1;
+        if (following != ranges.end() && next->offset + next->size == following->offset)
+        {
+            next->size += following->size;
+            ranges.erase(following);
+        }
+
+        // merge with the preceding range
+        if (next != ranges.begin())
+        {
+            auto preceding = next - 1;
+            if (preceding->offset + preceding->size == next->offset)
+            {
+                preceding->size += next->size;
+                ranges.erase(next);
+            }
+        }
+
+        a_block.used -= a_size;
+    }
+
+    vk::DeviceSize memory_allocator::preferred_block_size(uint32_t a_memory_type) const
+    {
+        const uint32_t heap = m_memory_properties.memoryTypes[a_memory_type].heapIndex;
+        const vk::DeviceSize heap_size = m_memory_properties.memoryHeaps[heap].size;
+
+        // small heaps (e.g. the 256 MiB host-visible device-local heap) get proportionally smaller blocks
+        return std::min(DEFAULT_BLOCK_SIZE, heap_size / 8);
+    }
+}
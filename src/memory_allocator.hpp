@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <mutex>
+#include <vector>
+
+namespace ppr
+{
+    // A sub-range of a device memory block handed out by memory_allocator
+    struct allocation
+    {
+        vk::DeviceMemory memory;
+        vk::DeviceSize offset = 0;
+        vk::DeviceSize size = 0;
+
+        // persistently mapped pointer to offset, null for memory that is not host visible
+        void* mapped = nullptr;
+
+        uint32_t memory_type = 0;
+        uint32_t pool = 0;
+
+        explicit operator bool() const
+        { return static_cast<bool>(memory); }
+    };
+
+    // Sub-allocates buffers and images out of large per-memory-type blocks instead
+    // of calling vkAllocateMemory per resource, keeping us far from
+    // maxMemoryAllocationCount and off the driver's allocation path.
+    //
+    // Linear resources (buffers) and optimally tiled images are placed in separate
+    // blocks, so neighbouring allocations can never violate bufferImageGranularity.
+    class memory_allocator
+    {
+    public:
+        enum class resource_kind
+        {
+            LINEAR,
+            OPTIMAL,
+        };
+
+    public:
+        memory_allocator(const vk::Device& a_device, const vk::PhysicalDevice& a_physical_device);
+
+        void init();
+        void destroy();
+
+        allocation allocate(const vk::MemoryRequirements& a_requirements,
+                                  vk::MemoryPropertyFlags a_properties,
+                                  resource_kind a_kind = resource_kind::LINEAR);
+        void free(const allocation& an_allocation);
+
+        // Allocate and bind in one step
+        allocation allocate_buffer(const vk::Buffer& a_buffer, vk::MemoryPropertyFlags a_properties);
+        allocation allocate_image(const vk::Image& an_image, vk::MemoryPropertyFlags a_properties);
+
+        uint32_t find_memory_type(uint32_t a_typefilter, vk::MemoryPropertyFlags a_properties) const;
+
+        // Whether a resource with these requirements can live in device-local memory the
+        // CPU writes directly (UMA, ReBAR), making a staging copy pointless. When only a
+        // small BAR window exists it is kept for small resources.
+        bool supports_direct_write(const vk::MemoryRequirements& a_requirements) const;
+
+        const vk::PhysicalDeviceMemoryProperties& memory_properties() const;
+
+    private:
+        struct free_range
+        {
+            vk::DeviceSize offset;
+            vk::DeviceSize size;
+        };
+
+        struct block
+        {
+            vk::DeviceMemory memory;
+            vk::DeviceSize size = 0;
+            vk::DeviceSize used = 0;
+            void* mapped = nullptr;
+
+            std::vector<free_range> free_ranges; // sorted by offset, never adjacent
+        };
+
+        // All blocks of one memory type holding one kind of resource
+        struct pool
+        {
+            uint32_t memory_type;
+            resource_kind kind;
+            std::vector<block> blocks;
+        };
+
+        uint32_t find_pool(uint32_t a_memory_type, resource_kind a_kind);
+        block& create_block(pool& a_pool, vk::DeviceSize a_min_size);
+        bool suballocate(block& a_block, const vk::MemoryRequirements& a_requirements, vk::DeviceSize& an_offset) const;
+        void release(block& a_block, vk::DeviceSize an_offset, vk::DeviceSize a_size) const;
+        vk::DeviceSize preferred_block_size(uint32_t a_memory_type) const;
+
+    private:
+        static constexpr vk::DeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+        static constexpr vk::DeviceSize SMALL_DIRECT_WRITE_SIZE = 256ull * 1024;
+
+    public:
+        static const vk::MemoryPropertyFlags DIRECT_WRITE_PROPERTIES;
+
+    private:
+
+        const vk::Device& m_device;
+        const vk::PhysicalDevice& m_physical_device;
+
+        vk::PhysicalDeviceMemoryProperties m_memory_properties;
+        uint32_t m_max_allocations;
+
+        bool m_direct_write;           // some type is device local, host visible and coherent
+        bool m_direct_write_unlimited; // ...and it spans the largest device-local heap
+        uint32_t m_block_count;
+
+        std::vector<pool> m_pools;
+        std::mutex m_mutex;
+    };
+}
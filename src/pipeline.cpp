@@ -2,14 +2,24 @@
 #include "util.hpp"
 #include "logger.hpp"
 
-#include <fstream>
+#include <algorithm>
+#include <cstddef>
 #include <string>
 
 namespace ppr
 {
-	pipeline::pipeline(const vk::Device& a_device, const vk::Extent2D& aViewport)
+	pipeline::pipeline(const vk::Device& a_device, 
+                       const pipeline_description& a_description, 
+                       const vk::PipelineCache& a_cache, 
+                             shader_module_cache& a_shader_modules, 
+                             pipeline_layout_cache& a_layouts, 
+                       const vk::DescriptorSetLayout& a_uniform_layout)
 		: m_device(a_device)
-		, m_viewport(aViewport)
+		, m_description(a_description)
+		, m_cache(a_cache)
+		, m_shader_modules(a_shader_modules)
+		, m_layouts(a_layouts)
+		, m_uniform_layout(a_uniform_layout)
 		, m_cleaned(false)
 	{}
 
@@ -18,54 +28,92 @@ namespace ppr
 
 	void pipeline::destroy() const
 	{
+		// the layout belongs to the layout cache
 		m_device.destroyPipeline(m_pipeline);
-		m_device.destroyPipelineLayout(m_pipe_layout);
-		m_device.destroyRenderPass(m_renderpass);
 	}
 
-	void pipeline::create()
+	bool pipeline::create()
 	{
 		log->trace("Creating graphics pipeline...");
 
-		const auto vert_shader_code = read_shader("shaders/vert.spv");
-        const auto frag_shader_code = read_shader("shaders/frag.spv");
-
-        const vk::ShaderModule vert_shader_module = create_shader_module(vert_shader_code);
-        const vk::ShaderModule frag_shader_module = create_shader_module(frag_shader_code);
+		m_vert_shader = m_shader_modules.acquire(m_description.vertex_shader, vk::ShaderStageFlagBits::eVertex, m_description.defines);
+        m_frag_shader = m_shader_modules.acquire(m_description.fragment_shader, vk::ShaderStageFlagBits::eFragment, m_description.defines);
+
+		if (!m_vert_shader || !m_frag_shader)
+		{
+			log->error("Failed to build shaders for the graphics pipeline.");
+			return false;
+		}
+
+		// Draws bind the uniform allocator's set through this pipeline's layout. Layouts are
+		// deduped by definition, so a different handle means incompatible declarations.
+		if (m_uniform_layout)
+		{
+			const auto set_layouts = m_layouts.set_layouts({ &m_vert_shader->reflection, &m_frag_shader->reflection });
+
+			if (set_layouts.empty() || set_layouts[0] != m_uniform_layout)
+			{
+				log->error("Set 0 of {} and {} doesn't match the shared uniform blocks, pipeline rejected.", 
+                           m_description.vertex_shader, m_description.fragment_shader);
+				m_vert_shader.reset();
+				m_frag_shader.reset();
+				return false;
+			}
+		}
 
 		log->trace("Initializing shader and pipeline info...");
 
-        const vk::PipelineShaderStageCreateInfo vert_shader_info({}, vk::ShaderStageFlagBits::eVertex, vert_shader_module, "main");
-        const vk::PipelineShaderStageCreateInfo frag_shader_info({}, vk::ShaderStageFlagBits::eFragment, frag_shader_module, "main");
+		std::vector<vk::SpecializationMapEntry> vert_entries, frag_entries;
+		const vk::SpecializationInfo vert_specialization = specialize(m_vert_shader->reflection, vert_entries);
+		const vk::SpecializationInfo frag_specialization = specialize(m_frag_shader->reflection, frag_entries);
+
+		for (const specialization_constant& constant : m_description.specialization)
+		{
+			const auto declares = [&constant](const shader_module_ref& a_shader)
+			{
+				const auto& ids = a_shader->reflection.specialization_ids;
+				return std::binary_search(ids.begin(), ids.end(), constant.id);
+			};
+
+			if (!declares(m_vert_shader) && !declares(m_frag_shader))
+			{
+				log->warn("Specialization constant {} is not declared by {} or {}", 
+                          constant.id, m_description.vertex_shader, m_description.fragment_shader);
+			}
+		}
+
+        const vk::PipelineShaderStageCreateInfo vert_shader_info({}, vk::ShaderStageFlagBits::eVertex, m_vert_shader->module, "main", 
+                                                                 vert_entries.empty() ? nullptr : &vert_specialization);
+        const vk::PipelineShaderStageCreateInfo frag_shader_info({}, vk::ShaderStageFlagBits::eFragment, m_frag_shader->module, "main", 
+                                                                 frag_entries.empty() ? nullptr : &frag_specialization);
 
         const vk::PipelineShaderStageCreateInfo shader_stages[] = { vert_shader_info, frag_shader_info };
 
-        const auto binding = vertex::binding_descript();
-        const auto attributes = vertex::attribute_descript();
+        std::vector<vk::VertexInputBindingDescription> bindings = m_description.bindings;
+        std::vector<vk::VertexInputAttributeDescription> attributes = m_description.attributes;
 
-        const vk::PipelineVertexInputStateCreateInfo vertex_inputinfo({}, 1, &binding, (uint32_t)attributes.size(), attributes.data());
+        if (attributes.empty())
+            reflect_vertex_input(bindings, attributes);
 
-        const vk::PipelineInputAssemblyStateCreateInfo input_assembly({}, vk::PrimitiveTopology::eTriangleList);
+        const vk::PipelineVertexInputStateCreateInfo vertex_inputinfo({}, 
+                                                                      (uint32_t)bindings.size(), 
+                                                                      bindings.data(), 
+                                                                      (uint32_t)attributes.size(), 
+                                                                      attributes.data());
 
-		vk::Viewport viewport = {};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = (float)m_viewport.width;
-		viewport.height = (float)m_viewport.height;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
+        const vk::PipelineInputAssemblyStateCreateInfo input_assembly({}, m_description.topology);
 
-		vk::Rect2D scissor = {};
-		scissor.offset = { 0, 0 };
-		scissor.extent = m_viewport;
+		// Viewport and scissor are set at record time, so window size never invalidates the pipeline
+        const vk::PipelineViewportStateCreateInfo viewport_state({}, 1, nullptr, 1, nullptr);
 
-        const vk::PipelineViewportStateCreateInfo viewport_state({}, 1, &viewport, 1, &scissor);
+        const vk::DynamicState dynamic_states[] = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+        const vk::PipelineDynamicStateCreateInfo dynamic_state({}, 2, dynamic_states);
 
         const vk::PipelineRasterizationStateCreateInfo rasterizer({}, 
                                                                   false, false, 
-                                                                  vk::PolygonMode::eFill, 
-                                                                  vk::CullModeFlagBits::eBack, 
-                                                                  vk::FrontFace::eClockwise, 
+                                                                  m_description.polygon_mode, 
+                                                                  m_description.cull_mode, 
+                                                                  m_description.front_face, 
                                                                   0, 0.f, 0.f, 0.f, 
                                                                   1.f);
 
@@ -75,94 +123,113 @@ namespace ppr
                                                                    1.0f);
 
 		vk::PipelineColorBlendAttachmentState color_blend_attachment = {};
-		color_blend_attachment.colorWriteMask = vk::ColorComponentFlagBits::eR 
-                                              | vk::ColorComponentFlagBits::eG 
-                                              | vk::ColorComponentFlagBits::eB 
-                                              | vk::ColorComponentFlagBits::eA;
-		color_blend_attachment.blendEnable = false;
-		color_blend_attachment.srcColorBlendFactor = vk::BlendFactor::eOne;
-		color_blend_attachment.dstColorBlendFactor = vk::BlendFactor::eZero;
-		color_blend_attachment.colorBlendOp = vk::BlendOp::eAdd;
-		color_blend_attachment.srcAlphaBlendFactor = vk::BlendFactor::eOne;
-		color_blend_attachment.dstAlphaBlendFactor = vk::BlendFactor::eZero;
-		color_blend_attachment.alphaBlendOp = vk::BlendOp::eAdd;
+		color_blend_attachment.colorWriteMask = m_description.color_write_mask;
+		color_blend_attachment.blendEnable = m_description.blend_enable;
+		color_blend_attachment.srcColorBlendFactor = m_description.src_color_factor;
+		color_blend_attachment.dstColorBlendFactor = m_description.dst_color_factor;
+		color_blend_attachment.colorBlendOp = m_description.color_op;
+		color_blend_attachment.srcAlphaBlendFactor = m_description.src_alpha_factor;
+		color_blend_attachment.dstAlphaBlendFactor = m_description.dst_alpha_factor;
+		color_blend_attachment.alphaBlendOp = m_description.alpha_op;
 
 		vk::PipelineColorBlendStateCreateInfo color_blend_global;
 		color_blend_global.logicOpEnable = false;
 		color_blend_global.attachmentCount = 1;
 		color_blend_global.pAttachments = &color_blend_attachment;
 
-		log->trace("Creating pipeline layout...");
+		vk::PipelineDepthStencilStateCreateInfo depth_stencil;
+		depth_stencil.depthTestEnable = m_description.depth_test;
+		depth_stencil.depthWriteEnable = m_description.depth_write;
+		depth_stencil.depthCompareOp = m_description.depth_compare;
 
-        const vk::PipelineLayoutCreateInfo layout_info;
+		const bool uses_depth = m_description.depth_test || m_description.depth_write;
 
-		m_pipe_layout = m_device.createPipelineLayout(layout_info);
+		m_pipe_layout = m_layouts.pipeline_layout({ &m_vert_shader->reflection, &m_frag_shader->reflection });
 
         const vk::GraphicsPipelineCreateInfo pipeline_info({}, 2, shader_stages, &vertex_inputinfo, &input_assembly, 
                                                            nullptr, &viewport_state, &rasterizer, &multisampling, 
-                                                           nullptr, &color_blend_global, 
-                                                           nullptr, m_pipe_layout, m_renderpass, 
-                                                           0, vk::Pipeline(), -1);
+                                                           uses_depth ? &depth_stencil : nullptr, &color_blend_global, 
+                                                           &dynamic_state, m_pipe_layout, m_description.renderpass, 
+                                                           m_description.subpass, vk::Pipeline(), -1);
 
-		if (print(m_device.createGraphicsPipelines(vk::PipelineCache(), 1, &pipeline_info, nullptr, &m_pipeline)) != vk::Result::eSuccess)
-			log->critical("Failed to create Vulkan graphics pipeline.");
+		const vk::Result result = m_device.createGraphicsPipelines(m_cache, 1, &pipeline_info, nullptr, &m_pipeline);
 
-		log->trace("Successfully created pipeline.");
+		if (print(result) != vk::Result::eSuccess)
+		{
+			log->error("Failed to create Vulkan graphics pipeline.");
+			return false;
+		}
 
-		m_device.destroyShaderModule(vert_shader_module);
-		m_device.destroyShaderModule(frag_shader_module);
+		log->trace("Successfully created pipeline.");
 
 		if (!m_initialized)
 			m_initialized = true;
+
+		return true;
 	}
 
-	vk::ShaderModule pipeline::create_shader_module(const std::vector<char>& a_bytecode) const
+	vk::Pipeline& pipeline::get()
 	{
-		log->trace("Creating shader module...");
-
-        const vk::ShaderModuleCreateInfo createinfo({}, 
-                                                    a_bytecode.size(), 
-                                                    reinterpret_cast<const uint32_t*>(a_bytecode.data()));
-        return m_device.createShaderModule(createinfo);
+		return m_pipeline;
 	}
 
-	std::vector<char> pipeline::read_shader(const std::string& a_filename)
+	const vk::Pipeline& pipeline::get() const
 	{
-		// open file at its end to know the filesize
-		std::ifstream shader(a_filename, std::ios::ate 
-                                       | std::ios::binary);
-
-		if (!shader.is_open())
-			log->critical("Failed to open shader \"{}\"",  a_filename);
-
-		// figure out file size based on buffer position
-        const size_t file_size = (size_t)shader.tellg();
-
-        log->trace("{} size: {}", a_filename, std::to_string(file_size));
-
-		std::vector<char> buffer(file_size);
-
-		// reset buffer position and read all bytes at once
-		shader.seekg(0);
-		shader.read(buffer.data(), file_size);
+		return m_pipeline;
+	}
 
-		shader.close();
+	vk::PipelineLayout& pipeline::get_layout()
+	{
+		return m_pipe_layout;
+	}
 
-		return buffer;
+	const vk::PipelineLayout& pipeline::get_layout() const
+	{
+		return m_pipe_layout;
 	}
 
-	vk::Pipeline& pipeline::get()
+	vk::SpecializationInfo pipeline::specialize(const shader_reflection& a_reflection, 
+                                                std::vector<vk::SpecializationMapEntry>& a_entries) const
 	{
-		return m_pipeline;
+		const auto& declared = a_reflection.specialization_ids;
+
+		// Entries point into the description's values, which outlive pipeline creation
+		for (size_t i = 0; i < m_description.specialization.size(); ++i)
+		{
+			const specialization_constant& constant = m_description.specialization[i];
+
+			if (std::binary_search(declared.begin(), declared.end(), constant.id))
+			{
+				a_entries.emplace_back(constant.id, 
+                                       static_cast<uint32_t>(i * sizeof(specialization_constant) + offsetof(specialization_constant, value)), 
+                                       sizeof(constant.value));
+			}
+		}
+
+		return vk::SpecializationInfo(static_cast<uint32_t>(a_entries.size()), 
+                                      a_entries.data(), 
+                                      m_description.specialization.size() * sizeof(specialization_constant), 
+                                      m_description.specialization.data());
 	}
 
-	vk::PipelineLayout& pipeline::get_layout()
+	void pipeline::reflect_vertex_input(std::vector<vk::VertexInputBindingDescription>& a_bindings, 
+                                        std::vector<vk::VertexInputAttributeDescription>& a_attributes) const
 	{
-		return m_pipe_layout;
+		// inputs are sorted by location, so packing them in order gives the vertex struct's layout
+		uint32_t stride = 0;
+		for (const auto& i_input : m_vert_shader->reflection.inputs)
+		{
+			a_attributes.emplace_back(i_input.location, 0, i_input.format, stride);
+			stride += i_input.size;
+		}
+
+		if (stride > 0)
+			a_bindings.assign(1, vk::VertexInputBindingDescription(0, stride, vk::VertexInputRate::eVertex));
 	}
 
-	vk::RenderPass& pipeline::get_renderpass()
+	const pipeline_description& pipeline::description() const
 	{
-		return m_renderpass;
+		return m_description;
 	}
+
 }
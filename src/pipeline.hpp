@@ -1,6 +1,10 @@
 #pragma once
 #include "vertex_buffer.hpp"
 #include "util.hpp"
+#include "globals.hpp"
+#include "shader_module_cache.hpp"
+#include "pipeline_description.hpp"
+#include "pipeline_layout_cache.hpp"
 
 #include <vulkan/vulkan.hpp>
 #include <glm/vec2.hpp>
@@ -13,26 +17,50 @@ namespace ppr
 	class pipeline : public common_checks
 	{
 	public:
-		pipeline(const vk::Device& a_device, const vk::Extent2D& a_viewport_size);
+		pipeline(const vk::Device& a_device, 
+                 const pipeline_description& a_description, 
+                 const vk::PipelineCache& a_cache, 
+                       shader_module_cache& a_shader_modules, 
+                       pipeline_layout_cache& a_layouts, 
+                 const vk::DescriptorSetLayout& a_uniform_layout = vk::DescriptorSetLayout());
 		~pipeline();
 
-		void create();
+		// Returns false (and leaves nothing behind) if the shaders or the pipeline fail to build,
+		// or if set 0 of the shaders isn't a_uniform_layout when one is given
+		bool create();
 		void destroy() const;
 
 		vk::Pipeline& get();
-		vk::RenderPass& get_renderpass();
+		const vk::Pipeline& get() const;
 		vk::PipelineLayout& get_layout();
+		const vk::PipelineLayout& get_layout() const;
 
-		vk::ShaderModule create_shader_module(const std::vector<char>& a_bytecode) const;
-		static std::vector<char> read_shader(const std::string& a_filename);
+		const pipeline_description& description() const;
+
+	private:
+		// Picks the description's constants the stage declares, unknown ids are left out
+		vk::SpecializationInfo specialize(const shader_reflection& a_reflection, 
+                                          std::vector<vk::SpecializationMapEntry>& a_entries) const;
+
+		void reflect_vertex_input(std::vector<vk::VertexInputBindingDescription>& a_bindings, 
+                                  std::vector<vk::VertexInputAttributeDescription>& a_attributes) const;
 
 	private:
 		const vk::Device& m_device;
-		const vk::Extent2D& m_viewport;
+		// By value, the caller's description may change while this compiles. The render pass
+		// is only a handle, the swapchain keeps it alive until the compiler is idle.
+		const pipeline_description m_description;
+		const vk::PipelineCache& m_cache;
+		shader_module_cache& m_shader_modules;
+		pipeline_layout_cache& m_layouts;
+		const vk::DescriptorSetLayout m_uniform_layout; // owned by the layout cache
+
+		// Held for the pipeline's lifetime so rebuilds find them still in the cache
+		shader_module_ref m_vert_shader;
+		shader_module_ref m_frag_shader;
 
 		vk::Pipeline m_pipeline;
-		vk::RenderPass m_renderpass;
-		vk::PipelineLayout m_pipe_layout;
+		vk::PipelineLayout m_pipe_layout; // shared, owned by the layout cache
 
 		bool m_cleaned;
 	};
@@ -0,0 +1,113 @@
+#include "pipeline_cache.hpp"
+#include "util.hpp"
+#include "logger.hpp"
+
+#include <cstring>
+
+namespace ppr
+{
+    namespace
+    {
+        // Layout of VK_PIPELINE_CACHE_HEADER_VERSION_ONE, all fields little endian
+        struct cache_header
+        {
+            uint32_t length;
+            uint32_t version;
+            uint32_t vendor_id;
+            uint32_t device_id;
+            uint8_t uuid[VK_UUID_SIZE];
+        };
+    }
+
+    pipeline_cache::pipeline_cache(const vk::Device& a_device, const vk::PhysicalDevice& a_physical_device)
+        : m_device(a_device)
+        , m_physical_device(a_physical_device)
+        , m_warm(false)
+    {}
+
+    void pipeline_cache::init(const std::string& a_path)
+    {
+        log->trace("Loading pipeline cache from \"{}\"...", a_path);
+
+        m_path = a_path;
+
+        std::vector<char> data;
+        if (!read_file(a_path, data))
+            data.clear();
+
+        if (!data.empty() && !validate_header(data))
+            data.clear();
+
+        m_warm = !data.empty();
+        m_cache = m_device.createPipelineCache(vk::PipelineCacheCreateInfo({}, data.size(), data.data()));
+
+        if (m_warm)
+            log->info("Loaded {} KiB pipeline cache.", data.size() / 1024);
+        else
+            log->info("No usable pipeline cache, pipelines are compiled cold.");
+    }
+
+    void pipeline_cache::save() const
+    {
+        if (!m_cache)
+            return;
+
+        const std::vector<uint8_t> data = m_device.getPipelineCacheData(m_cache);
+
+        if (!write_file(m_path, data.data(), data.size()))
+        {
+            log->warn("Failed to write pipeline cache to \"{}\".", m_path);
+            return;
+        }
+
+        log->debug("Saved {} KiB pipeline cache to \"{}\".", data.size() / 1024, m_path);
+    }
+
+    void pipeline_cache::destroy()
+    {
+        m_device.destroyPipelineCache(m_cache);
+        m_cache = nullptr;
+    }
+
+    const vk::PipelineCache& pipeline_cache::get() const
+    {
+        return m_cache;
+    }
+
+    bool pipeline_cache::is_warm() const
+    {
+        return m_warm;
+    }
+
+    bool pipeline_cache::validate_header(const std::vector<char>& a_data) const
+    {
+        cache_header header;
+
+        if (a_data.size() < sizeof(header))
+        {
+            log->warn("Pipeline cache is truncated, ignoring it.");
+            return false;
+        }
+
+        memcpy(&header, a_data.data(), sizeof(header));
+
+        const vk::PhysicalDeviceProperties properties = m_physical_device.getProperties();
+
+        if (header.length < sizeof(header) 
+         || header.version != static_cast<uint32_t>(vk::PipelineCacheHeaderVersion::eOne))
+        {
+            log->warn("Pipeline cache has an unknown header version, ignoring it.");
+            return false;
+        }
+
+        if (header.vendor_id != properties.vendorID 
+         || header.device_id != properties.deviceID 
+         || memcmp(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+        {
+            log->info("Pipeline cache was written by a different device or driver, ignoring it.");
+            return false;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <string>
+#include <vector>
+
+namespace ppr
+{
+    // Device-wide VkPipelineCache persisted between runs. The blob on disk is
+    // only accepted when its header matches this exact device and driver, so a
+    // GPU or driver change falls back to an empty cache instead of feeding the
+    // driver data it can't use.
+    class pipeline_cache
+    {
+    public:
+        pipeline_cache(const vk::Device& a_device, const vk::PhysicalDevice& a_physical_device);
+
+        void init(const std::string& a_path);
+        void save() const;
+        void destroy();
+
+        const vk::PipelineCache& get() const;
+
+        // whether init() found a usable cache on disk
+        bool is_warm() const;
+
+    private:
+        bool validate_header(const std::vector<char>& a_data) const;
+
+    private:
+        const vk::Device& m_device;
+        const vk::PhysicalDevice& m_physical_device;
+
+        std::string m_path;
+        vk::PipelineCache m_cache;
+        bool m_warm;
+    };
+}
@@ -0,0 +1,165 @@
+#include "pipeline_compiler.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+
+namespace ppr
+{
+    async_pipeline::async_pipeline(pipeline&& a_pipeline)
+        : m_pipeline(std::move(a_pipeline))
+        , m_status(pipeline_status::PENDING)
+    {}
+
+    pipeline_status async_pipeline::status() const
+    {
+        return m_status;
+    }
+
+    bool async_pipeline::is_ready() const
+    {
+        return m_status == pipeline_status::READY;
+    }
+
+    pipeline& async_pipeline::get()
+    {
+        return m_pipeline;
+    }
+
+    const pipeline& async_pipeline::get() const
+    {
+        return m_pipeline;
+    }
+
+    bool async_pipeline::discard()
+    {
+        pipeline_status expected = pipeline_status::PENDING;
+
+        if (m_status.compare_exchange_strong(expected, pipeline_status::DISCARDED))
+            return false;
+
+        if (expected == pipeline_status::READY)
+        {
+            m_status = pipeline_status::DISCARDED;
+            return true;
+        }
+
+        return false;
+    }
+
+    void async_pipeline::run()
+    {
+        // discarded while still queued
+        if (m_status != pipeline_status::PENDING)
+            return;
+
+        const bool created = m_pipeline.create();
+
+        pipeline_status expected = pipeline_status::PENDING;
+        if (!m_status.compare_exchange_strong(expected, created ? pipeline_status::READY : pipeline_status::FAILED))
+        {
+            // discarded while being created, nothing can have used it
+            if (created)
+                m_pipeline.destroy();
+        }
+    }
+
+    pipeline_compiler::pipeline_compiler(uint32_t a_thread_count)
+        : m_thread_count(a_thread_count)
+        , m_running(0)
+        , m_stopping(false)
+    {
+        if (m_thread_count == 0)
+            m_thread_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    }
+
+    pipeline_compiler::~pipeline_compiler()
+    {
+        destroy();
+    }
+
+    void pipeline_compiler::init()
+    {
+        m_stopping = false;
+
+        for (uint32_t i = 0; i < m_thread_count; ++i)
+            m_threads.emplace_back(&pipeline_compiler::work, this);
+
+        log->debug("Started {} pipeline compiler threads.", m_thread_count);
+    }
+
+    void pipeline_compiler::destroy()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+
+        m_work_available.notify_all();
+
+        // queued work is finished first, handles never stay PENDING forever
+        for (auto& i_thread : m_threads)
+            i_thread.join();
+
+        m_threads.clear();
+    }
+
+    pipeline_handle pipeline_compiler::submit(pipeline&& a_pipeline)
+    {
+        auto handle = std::make_shared<async_pipeline>(std::move(a_pipeline));
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.push_back(handle);
+        }
+
+        m_work_available.notify_one();
+        return handle;
+    }
+
+    void pipeline_compiler::wait(const pipeline_handle& a_handle)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_work_done.wait(lock, [&a_handle]() { return a_handle->status() != pipeline_status::PENDING; });
+    }
+
+    void pipeline_compiler::wait_idle()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_work_done.wait(lock, [this]() { return m_queue.empty() && m_running == 0; });
+    }
+
+    size_t pipeline_compiler::pending() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_queue.size() + m_running;
+    }
+
+    uint32_t pipeline_compiler::thread_count() const
+    {
+        return m_thread_count;
+    }
+
+    void pipeline_compiler::work()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (true)
+        {
+            m_work_available.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+
+            if (m_queue.empty())
+                return;
+
+            const pipeline_handle job = std::move(m_queue.front());
+            m_queue.pop_front();
+            ++m_running;
+
+            lock.unlock();
+            job->run();
+            lock.lock();
+
+            --m_running;
+            m_work_done.notify_all();
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "pipeline.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ppr
+{
+    enum class pipeline_status : uint8_t
+    {
+        PENDING,
+        READY,
+        FAILED,
+        DISCARDED
+    };
+
+    // A pipeline being created on a compiler thread. The owner and the worker
+    // only ever race through the status, whoever loses a transition out of
+    // PENDING is responsible for the pipeline.
+    class async_pipeline
+    {
+    public:
+        explicit async_pipeline(pipeline&& a_pipeline);
+
+        pipeline_status status() const;
+        bool is_ready() const;
+
+        // Only valid once ready
+        pipeline& get();
+        const pipeline& get() const;
+
+        // Gives up on the pipeline. Returns true if it was already created, in
+        // which case the caller destroys it, otherwise the worker drops it.
+        bool discard();
+
+    private:
+        friend class pipeline_compiler;
+        void run();
+
+    private:
+        pipeline m_pipeline;
+        std::atomic<pipeline_status> m_status;
+    };
+
+    using pipeline_handle = std::shared_ptr<async_pipeline>;
+
+    // Worker pool that creates pipelines off the render thread. Every worker
+    // shares the one vk::PipelineCache, drivers synchronize access internally.
+    class pipeline_compiler
+    {
+    public:
+        // 0 picks one thread less than the hardware has, leaving a core to the render
+        // thread, but at least one
+        explicit pipeline_compiler(uint32_t a_thread_count = 0);
+        ~pipeline_compiler();
+
+        pipeline_compiler(const pipeline_compiler&) = delete;
+        pipeline_compiler& operator=(const pipeline_compiler&) = delete;
+
+        void init();
+        void destroy();
+
+        // Returns immediately, the handle reports ready once a worker created it
+        pipeline_handle submit(pipeline&& a_pipeline);
+
+        // Blocks until the handle left PENDING, for callers that can't do without it
+        void wait(const pipeline_handle& a_handle);
+        void wait_idle();
+
+        size_t pending() const;
+        uint32_t thread_count() const;
+
+    private:
+        void work();
+
+    private:
+        uint32_t m_thread_count;
+        std::vector<std::thread> m_threads;
+
+        std::deque<pipeline_handle> m_queue;
+        size_t m_running;
+        bool m_stopping;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_work_available;
+        std::condition_variable m_work_done;
+    };
+}
@@ -0,0 +1,296 @@
+#include "pipeline_description.hpp"
+#include "globals.hpp"
+#include "util.hpp"
+
+#include <cstring>
+#include <type_traits>
+
+namespace ppr
+{
+    namespace
+    {
+        template<typename T>
+        uint64_t hash_value(const T& a_value, uint64_t a_seed)
+        {
+            return hash_bytes(&a_value, sizeof(a_value), a_seed);
+        }
+
+        // Flags and handles wrap a single integer, hash that rather than the wrapper
+        template<typename BitType, typename MaskType>
+        uint64_t hash_flags(const vk::Flags<BitType, MaskType>& a_flags, uint64_t a_seed)
+        {
+            return hash_value(static_cast<MaskType>(a_flags), a_seed);
+        }
+
+        // Raw bytes of trivially copyable values (enums, plain structs)
+        template<typename T>
+        void write_value(std::vector<char>& a_out, const T& a_value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "only plain values are written as bytes");
+
+            const char* bytes = reinterpret_cast<const char*>(&a_value);
+            a_out.insert(a_out.end(), bytes, bytes + sizeof(T));
+        }
+
+        template<typename T>
+        bool read_value(const char*& a_cursor, const char* a_end, T& a_value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "only plain values are read as bytes");
+
+            if (static_cast<size_t>(a_end - a_cursor) < sizeof(T))
+                return false;
+
+            memcpy(&a_value, a_cursor, sizeof(T));
+            a_cursor += sizeof(T);
+            return true;
+        }
+
+        // Flags have a user-provided copy constructor, so they go through their mask
+        template<typename BitType, typename MaskType>
+        void write_value(std::vector<char>& a_out, const vk::Flags<BitType, MaskType>& a_flags)
+        {
+            write_value(a_out, static_cast<MaskType>(a_flags));
+        }
+
+        template<typename BitType, typename MaskType>
+        bool read_value(const char*& a_cursor, const char* a_end, vk::Flags<BitType, MaskType>& a_flags)
+        {
+            MaskType mask = 0;
+            if (!read_value(a_cursor, a_end, mask))
+                return false;
+
+            a_flags = vk::Flags<BitType, MaskType>(mask);
+            return true;
+        }
+
+        void write_string(std::vector<char>& a_out, const std::string& a_string)
+        {
+            write_value(a_out, static_cast<uint32_t>(a_string.size()));
+            a_out.insert(a_out.end(), a_string.begin(), a_string.end());
+        }
+
+        bool read_string(const char*& a_cursor, const char* a_end, std::string& a_string)
+        {
+            uint32_t size = 0;
+            if (!read_value(a_cursor, a_end, size) || static_cast<size_t>(a_end - a_cursor) < size)
+                return false;
+
+            a_string.assign(a_cursor, size);
+            a_cursor += size;
+            return true;
+        }
+
+        template<typename T>
+        void write_array(std::vector<char>& a_out, const std::vector<T>& a_values)
+        {
+            write_value(a_out, static_cast<uint32_t>(a_values.size()));
+            for (const auto& i_value : a_values)
+                write_value(a_out, i_value);
+        }
+
+        template<typename T>
+        bool read_array(const char*& a_cursor, const char* a_end, std::vector<T>& a_values)
+        {
+            uint32_t count = 0;
+            if (!read_value(a_cursor, a_end, count) || static_cast<size_t>(a_end - a_cursor) / sizeof(T) < count)
+                return false;
+
+            a_values.resize(count);
+            for (auto& i_value : a_values)
+                read_value(a_cursor, a_end, i_value);
+
+            return true;
+        }
+    }
+
+    specialization_constant specialization_constant::from_float(uint32_t a_id, float a_value)
+    {
+        specialization_constant constant = { a_id, 0 };
+        memcpy(&constant.value, &a_value, sizeof(a_value));
+        return constant;
+    }
+
+    specialization_constant specialization_constant::from_bool(uint32_t a_id, bool a_value)
+    {
+        // VkBool32
+        return { a_id, a_value ? 1u : 0u };
+    }
+
+    bool operator==(const specialization_constant& a_lhs, const specialization_constant& a_rhs)
+    {
+        return a_lhs.id == a_rhs.id && a_lhs.value == a_rhs.value;
+    }
+
+    pipeline_description::pipeline_description()
+        : vertex_shader(std::string(SHADER_DIR) + "shader.vert")
+        , fragment_shader(std::string(SHADER_DIR) + "shader.frag")
+    {}
+
+    uint64_t pipeline_description::hash() const
+    {
+        uint64_t hash = hash_string(vertex_shader);
+        hash = hash_string(fragment_shader, hash);
+
+        for (const auto& i_define : defines)
+        {
+            hash = hash_string(i_define.name, hash);
+            hash = hash_string(i_define.value, hash);
+        }
+
+        // plain structs of 32-bit fields, no padding
+        for (const auto& i_constant : specialization)
+            hash = hash_value(i_constant, hash);
+
+        for (const auto& i_binding : bindings)
+            hash = hash_value(i_binding, hash);
+
+        for (const auto& i_attribute : attributes)
+            hash = hash_value(i_attribute, hash);
+
+        hash = hash_value(topology, hash);
+        hash = hash_value(polygon_mode, hash);
+        hash = hash_flags(cull_mode, hash);
+        hash = hash_value(front_face, hash);
+
+        hash = hash_value(blend_enable, hash);
+        hash = hash_value(src_color_factor, hash);
+        hash = hash_value(dst_color_factor, hash);
+        hash = hash_value(color_op, hash);
+        hash = hash_value(src_alpha_factor, hash);
+        hash = hash_value(dst_alpha_factor, hash);
+        hash = hash_value(alpha_op, hash);
+        hash = hash_flags(color_write_mask, hash);
+
+        hash = hash_value(depth_test, hash);
+        hash = hash_value(depth_write, hash);
+        hash = hash_value(depth_compare, hash);
+
+        hash = hash_value(color_format, hash);
+        hash = hash_value(subpass, hash);
+
+        return hash;
+    }
+
+    void pipeline_description::serialize(std::vector<char>& a_out) const
+    {
+        write_string(a_out, vertex_shader);
+        write_string(a_out, fragment_shader);
+
+        write_value(a_out, static_cast<uint32_t>(defines.size()));
+        for (const auto& i_define : defines)
+        {
+            write_string(a_out, i_define.name);
+            write_string(a_out, i_define.value);
+        }
+
+        write_array(a_out, specialization);
+        write_array(a_out, bindings);
+        write_array(a_out, attributes);
+        write_value(a_out, topology);
+
+        write_value(a_out, polygon_mode);
+        write_value(a_out, cull_mode);
+        write_value(a_out, front_face);
+
+        write_value(a_out, blend_enable);
+        write_value(a_out, src_color_factor);
+        write_value(a_out, dst_color_factor);
+        write_value(a_out, color_op);
+        write_value(a_out, src_alpha_factor);
+        write_value(a_out, dst_alpha_factor);
+        write_value(a_out, alpha_op);
+        write_value(a_out, color_write_mask);
+
+        write_value(a_out, depth_test);
+        write_value(a_out, depth_write);
+        write_value(a_out, depth_compare);
+
+        write_value(a_out, subpass);
+    }
+
+    bool pipeline_description::deserialize(const char*& a_cursor, const char* a_end)
+    {
+        uint32_t define_count = 0;
+
+        if (!read_string(a_cursor, a_end, vertex_shader) 
+            || !read_string(a_cursor, a_end, fragment_shader) 
+            || !read_value(a_cursor, a_end, define_count))
+            return false;
+
+        // two length prefixes at least, guards the resize against a corrupt count
+        if (static_cast<size_t>(a_end - a_cursor) / (2 * sizeof(uint32_t)) < define_count)
+            return false;
+
+        defines.resize(define_count);
+        for (auto& i_define : defines)
+        {
+            if (!read_string(a_cursor, a_end, i_define.name) || !read_string(a_cursor, a_end, i_define.value))
+                return false;
+        }
+
+        return read_array(a_cursor, a_end, specialization) 
+            && read_array(a_cursor, a_end, bindings) 
+            && read_array(a_cursor, a_end, attributes) 
+            && read_value(a_cursor, a_end, topology) 
+            && read_value(a_cursor, a_end, polygon_mode) 
+            && read_value(a_cursor, a_end, cull_mode) 
+            && read_value(a_cursor, a_end, front_face) 
+            && read_value(a_cursor, a_end, blend_enable) 
+            && read_value(a_cursor, a_end, src_color_factor) 
+            && read_value(a_cursor, a_end, dst_color_factor) 
+            && read_value(a_cursor, a_end, color_op) 
+            && read_value(a_cursor, a_end, src_alpha_factor) 
+            && read_value(a_cursor, a_end, dst_alpha_factor) 
+            && read_value(a_cursor, a_end, alpha_op) 
+            && read_value(a_cursor, a_end, color_write_mask) 
+            && read_value(a_cursor, a_end, depth_test) 
+            && read_value(a_cursor, a_end, depth_write) 
+            && read_value(a_cursor, a_end, depth_compare) 
+            && read_value(a_cursor, a_end, subpass);
+    }
+
+    bool operator==(const pipeline_description& a_lhs, const pipeline_description& a_rhs)
+    {
+        const auto same_defines = [&a_lhs, &a_rhs]()
+        {
+            if (a_lhs.defines.size() != a_rhs.defines.size())
+                return false;
+
+            for (size_t i = 0; i < a_lhs.defines.size(); ++i)
+                if (a_lhs.defines[i].name != a_rhs.defines[i].name || a_lhs.defines[i].value != a_rhs.defines[i].value)
+                    return false;
+
+            return true;
+        };
+
+        // the render pass handle is deliberately left out, see color_format
+        return a_lhs.vertex_shader    == a_rhs.vertex_shader
+            && a_lhs.fragment_shader  == a_rhs.fragment_shader
+            && same_defines()
+            && a_lhs.specialization   == a_rhs.specialization
+            && a_lhs.bindings         == a_rhs.bindings
+            && a_lhs.attributes       == a_rhs.attributes
+            && a_lhs.topology         == a_rhs.topology
+            && a_lhs.polygon_mode     == a_rhs.polygon_mode
+            && a_lhs.cull_mode        == a_rhs.cull_mode
+            && a_lhs.front_face       == a_rhs.front_face
+            && a_lhs.blend_enable     == a_rhs.blend_enable
+            && a_lhs.src_color_factor == a_rhs.src_color_factor
+            && a_lhs.dst_color_factor == a_rhs.dst_color_factor
+            && a_lhs.color_op         == a_rhs.color_op
+            && a_lhs.src_alpha_factor == a_rhs.src_alpha_factor
+            && a_lhs.dst_alpha_factor == a_rhs.dst_alpha_factor
+            && a_lhs.alpha_op         == a_rhs.alpha_op
+            && a_lhs.color_write_mask == a_rhs.color_write_mask
+            && a_lhs.depth_test       == a_rhs.depth_test
+            && a_lhs.depth_write      == a_rhs.depth_write
+            && a_lhs.depth_compare    == a_rhs.depth_compare
+            && a_lhs.color_format     == a_rhs.color_format
+            && a_lhs.subpass          == a_rhs.subpass;
+    }
+
+    bool operator!=(const pipeline_description& a_lhs, const pipeline_description& a_rhs)
+    {
+        return !(a_lhs == a_rhs);
+    }
+}
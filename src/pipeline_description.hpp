@@ -0,0 +1,88 @@
+#pragma once
+
+#include "shader_compiler.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <string>
+#include <vector>
+
+namespace ppr
+{
+    // Value for a `layout(constant_id = N)` constant. Every scalar spec constant
+    // is 32 bits wide, floats and bools are stored as their bit pattern.
+    struct specialization_constant
+    {
+        uint32_t id;
+        uint32_t value;
+
+        static specialization_constant from_float(uint32_t a_id, float a_value);
+        static specialization_constant from_bool(uint32_t a_id, bool a_value);
+    };
+
+    bool operator==(const specialization_constant& a_lhs, const specialization_constant& a_rhs);
+
+    // Everything that goes into a graphics pipeline. Two descriptions that compare
+    // equal produce interchangeable pipelines, which is what the registry dedupes on.
+    struct pipeline_description
+    {
+        pipeline_description();
+
+        // shaders, paths relative to the working directory
+        std::string vertex_shader;
+        std::string fragment_shader;
+        std::vector<shader_define> defines; // applied to every stage
+
+        // Variants of one module. Unlike defines they don't produce new SPIR-V, so
+        // every variant shares the compiled and cached shader modules. Applied to
+        // each stage that declares the id. The registry sorts them by id, a repeated
+        // id keeps its last value.
+        std::vector<specialization_constant> specialization;
+
+        // Vertex input. Left empty, it is reflected from the vertex shader as one
+        // tightly packed per-vertex binding in location order.
+        std::vector<vk::VertexInputBindingDescription> bindings;
+        std::vector<vk::VertexInputAttributeDescription> attributes;
+        vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
+
+        // rasterization
+        vk::PolygonMode polygon_mode = vk::PolygonMode::eFill;
+        vk::CullModeFlags cull_mode = vk::CullModeFlagBits::eBack;
+        vk::FrontFace front_face = vk::FrontFace::eClockwise;
+
+        // blending, for the single color attachment
+        bool blend_enable = false;
+        vk::BlendFactor src_color_factor = vk::BlendFactor::eOne;
+        vk::BlendFactor dst_color_factor = vk::BlendFactor::eZero;
+        vk::BlendOp color_op = vk::BlendOp::eAdd;
+        vk::BlendFactor src_alpha_factor = vk::BlendFactor::eOne;
+        vk::BlendFactor dst_alpha_factor = vk::BlendFactor::eZero;
+        vk::BlendOp alpha_op = vk::BlendOp::eAdd;
+        vk::ColorComponentFlags color_write_mask = vk::ColorComponentFlagBits::eR 
+                                                 | vk::ColorComponentFlagBits::eG 
+                                                 | vk::ColorComponentFlagBits::eB 
+                                                 | vk::ColorComponentFlagBits::eA;
+
+        // depth, only valid with a render pass that has a depth attachment
+        bool depth_test = false;
+        bool depth_write = false;
+        vk::CompareOp depth_compare = vk::CompareOp::eLess;
+
+        // Render pass compatibility. Only the attachment format and subpass are
+        // hashed, any compatible render pass can be used to create the pipeline.
+        // The pipeline layout is not part of the description, it is reflected.
+        vk::Format color_format = vk::Format::eUndefined;
+        uint32_t subpass = 0;
+        vk::RenderPass renderpass;
+
+        uint64_t hash() const;
+
+        // Compact binary form for the pipeline usage file. The render pass and format
+        // are left out, they are filled in again by whoever loads it.
+        void serialize(std::vector<char>& a_out) const;
+        bool deserialize(const char*& a_cursor, const char* a_end);
+    };
+
+    bool operator==(const pipeline_description& a_lhs, const pipeline_description& a_rhs);
+    bool operator!=(const pipeline_description& a_lhs, const pipeline_description& a_rhs);
+}
@@ -0,0 +1,222 @@
+#include "pipeline_layout_cache.hpp"
+#include "util.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <map>
+
+namespace ppr
+{
+    namespace
+    {
+        // Every binding is visible to every graphics stage. A binding then means the
+        // same thing whichever stages happen to read it, and layouts of shaders that
+        // only differ in that still come out identical.
+        const vk::ShaderStageFlags BINDING_STAGES = vk::ShaderStageFlagBits::eAllGraphics;
+
+        uint64_t hash_bindings(const std::vector<vk::DescriptorSetLayoutBinding>& a_bindings)
+        {
+            uint64_t hash = HASH_SEED;
+
+            for (const auto& i_binding : a_bindings)
+            {
+                const uint32_t fields[] = { i_binding.binding, 
+                                            static_cast<uint32_t>(i_binding.descriptorType), 
+                                            i_binding.descriptorCount, 
+                                            static_cast<uint32_t>(i_binding.stageFlags) };
+                hash = hash_bytes(fields, sizeof(fields), hash);
+            }
+
+            return hash;
+        }
+
+        uint64_t hash_pipeline_layout(const std::vector<vk::DescriptorSetLayout>& a_set_layouts, 
+                                      const std::vector<vk::PushConstantRange>& a_push_constants)
+        {
+            uint64_t hash = HASH_SEED;
+
+            for (const auto& i_layout : a_set_layouts)
+            {
+                const VkDescriptorSetLayout handle = i_layout;
+                hash = hash_bytes(&handle, sizeof(handle), hash);
+            }
+
+            for (const auto& i_range : a_push_constants)
+            {
+                const uint32_t fields[] = { static_cast<uint32_t>(i_range.stageFlags), i_range.offset, i_range.size };
+                hash = hash_bytes(fields, sizeof(fields), hash);
+            }
+
+            return hash;
+        }
+    }
+
+    pipeline_layout_cache::pipeline_layout_cache(const vk::Device& a_device)
+        : m_device(a_device)
+    {}
+
+    void pipeline_layout_cache::destroy()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        log->debug("Destroying {} pipeline layouts and {} descriptor set layouts.", 
+                   m_pipeline_layouts.size(), m_set_layouts.size());
+
+        for (const auto& i_entry : m_pipeline_layouts)
+            m_device.destroyPipelineLayout(i_entry.second.layout);
+
+        for (const auto& i_entry : m_set_layouts)
+            m_device.destroyDescriptorSetLayout(i_entry.second.layout);
+
+        m_pipeline_layouts.clear();
+        m_set_layouts.clear();
+    }
+
+    std::vector<vk::DescriptorSetLayout> pipeline_layout_cache::set_layouts(std::initializer_list<const shader_reflection*> a_stages)
+    {
+        // merge every stage's bindings, a set used by several stages gets one layout
+        std::map<uint32_t, std::map<uint32_t, vk::DescriptorSetLayoutBinding>> sets;
+
+        for (const shader_reflection* i_stage : a_stages)
+        {
+            for (const auto& i_binding : i_stage->bindings)
+            {
+                const vk::DescriptorType type = i_binding.type == vk::DescriptorType::eUniformBuffer 
+                                              ? vk::DescriptorType::eUniformBufferDynamic 
+                                              : i_binding.type;
+
+                auto& merged = sets[i_binding.set];
+                const auto existing = merged.find(i_binding.binding);
+
+                if (existing == merged.end())
+                    merged.emplace(i_binding.binding, vk::DescriptorSetLayoutBinding(i_binding.binding, type, i_binding.count, BINDING_STAGES));
+                else if (existing->second.descriptorType != type)
+                    log->error("Shader stages disagree on the type of set {} binding {}.", i_binding.set, i_binding.binding);
+                else
+                    existing->second.descriptorCount = std::max(existing->second.descriptorCount, i_binding.count);
+            }
+        }
+
+        // set numbers are indices into the layout, gaps get an empty set
+        const uint32_t set_count = sets.empty() ? 0 : sets.rbegin()->first + 1;
+
+        std::vector<vk::DescriptorSetLayout> layouts;
+        for (uint32_t i = 0; i < set_count; ++i)
+        {
+            std::vector<vk::DescriptorSetLayoutBinding> bindings;
+
+            const auto found = sets.find(i);
+            if (found != sets.end())
+                for (const auto& i_binding : found->second)
+                    bindings.push_back(i_binding.second);
+
+            layouts.push_back(set_layout(std::move(bindings)));
+        }
+
+        return layouts;
+    }
+
+    vk::PipelineLayout pipeline_layout_cache::pipeline_layout(std::initializer_list<const shader_reflection*> a_stages)
+    {
+        // one range covering every stage's block, stages then share one push call
+        std::vector<vk::PushConstantRange> push_constants;
+
+        for (const shader_reflection* i_stage : a_stages)
+        {
+            for (const auto& i_range : i_stage->push_constants)
+            {
+                if (push_constants.empty())
+                {
+                    push_constants.push_back(i_range);
+                    continue;
+                }
+
+                vk::PushConstantRange& merged = push_constants.front();
+                const uint32_t end = std::max(merged.offset + merged.size, i_range.offset + i_range.size);
+
+                merged.offset = std::min(merged.offset, i_range.offset);
+                merged.size = end - merged.offset;
+                merged.stageFlags |= i_range.stageFlags;
+            }
+        }
+
+        return pipeline_layout(set_layouts(a_stages), push_constants);
+    }
+
+    vk::DescriptorSetLayout pipeline_layout_cache::set_layout(std::vector<vk::DescriptorSetLayoutBinding> a_bindings)
+    {
+        std::sort(a_bindings.begin(), a_bindings.end(), 
+                  [](const vk::DescriptorSetLayoutBinding& a_lhs, const vk::DescriptorSetLayoutBinding& a_rhs)
+        {
+            return a_lhs.binding < a_rhs.binding;
+        });
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return find_or_create_set_layout(a_bindings);
+    }
+
+    vk::PipelineLayout pipeline_layout_cache::pipeline_layout(const std::vector<vk::DescriptorSetLayout>& a_set_layouts, 
+                                                              const std::vector<vk::PushConstantRange>& a_push_constants)
+    {
+        const uint64_t hash = hash_pipeline_layout(a_set_layouts, a_push_constants);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const auto range = m_pipeline_layouts.equal_range(hash);
+        for (auto i_entry = range.first; i_entry != range.second; ++i_entry)
+        {
+            if (i_entry->second.set_layouts == a_set_layouts && i_entry->second.push_constants == a_push_constants)
+                return i_entry->second.layout;
+        }
+
+        const vk::PipelineLayoutCreateInfo layout_info({}, 
+                                                       static_cast<uint32_t>(a_set_layouts.size()), 
+                                                       a_set_layouts.data(), 
+                                                       static_cast<uint32_t>(a_push_constants.size()), 
+                                                       a_push_constants.data());
+
+        pipeline_layout_entry entry;
+        entry.set_layouts = a_set_layouts;
+        entry.push_constants = a_push_constants;
+        entry.layout = m_device.createPipelineLayout(layout_info);
+
+        log->trace("Created pipeline layout with {} sets and {} push constant ranges.", 
+                   a_set_layouts.size(), a_push_constants.size());
+
+        m_pipeline_layouts.emplace(hash, entry);
+        return entry.layout;
+    }
+
+    size_t pipeline_layout_cache::set_layout_count() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_set_layouts.size();
+    }
+
+    size_t pipeline_layout_cache::pipeline_layout_count() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_pipeline_layouts.size();
+    }
+
+    vk::DescriptorSetLayout pipeline_layout_cache::find_or_create_set_layout(const std::vector<vk::DescriptorSetLayoutBinding>& a_bindings)
+    {
+        const uint64_t hash = hash_bindings(a_bindings);
+
+        const auto range = m_set_layouts.equal_range(hash);
+        for (auto i_entry = range.first; i_entry != range.second; ++i_entry)
+        {
+            if (i_entry->second.bindings == a_bindings)
+                return i_entry->second.layout;
+        }
+
+        const vk::DescriptorSetLayoutCreateInfo layout_info({}, static_cast<uint32_t>(a_bindings.size()), a_bindings.data());
+
+        set_layout_entry entry;
+        entry.bindings = a_bindings;
+        entry.layout = m_device.createDescriptorSetLayout(layout_info);
+
+        m_set_layouts.emplace(hash, entry);
+        return entry.layout;
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "spirv_reflection.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <initializer_list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ppr
+{
+    // Creates descriptor set layouts and pipeline layouts from shader reflection
+    // and hands out the same handle for identical definitions, so pipelines with
+    // compatible shaders share one vk::PipelineLayout and can bind the same sets.
+    // Owns every layout it returns, they live until destroy().
+    class pipeline_layout_cache
+    {
+    public:
+        explicit pipeline_layout_cache(const vk::Device& a_device);
+
+        void destroy();
+
+        // All thread-safe. Uniform blocks are declared dynamic, the renderer binds
+        // them through the per-frame uniform allocator with dynamic offsets.
+        std::vector<vk::DescriptorSetLayout> set_layouts(std::initializer_list<const shader_reflection*> a_stages);
+        vk::PipelineLayout pipeline_layout(std::initializer_list<const shader_reflection*> a_stages);
+
+        vk::DescriptorSetLayout set_layout(std::vector<vk::DescriptorSetLayoutBinding> a_bindings);
+        vk::PipelineLayout pipeline_layout(const std::vector<vk::DescriptorSetLayout>& a_set_layouts, 
+                                           const std::vector<vk::PushConstantRange>& a_push_constants);
+
+        size_t set_layout_count() const;
+        size_t pipeline_layout_count() const;
+
+    private:
+        vk::DescriptorSetLayout find_or_create_set_layout(const std::vector<vk::DescriptorSetLayoutBinding>& a_bindings);
+
+    private:
+        struct set_layout_entry
+        {
+            std::vector<vk::DescriptorSetLayoutBinding> bindings;
+            vk::DescriptorSetLayout layout;
+        };
+
+        struct pipeline_layout_entry
+        {
+            std::vector<vk::DescriptorSetLayout> set_layouts;
+            std::vector<vk::PushConstantRange> push_constants;
+            vk::PipelineLayout layout;
+        };
+
+        const vk::Device& m_device;
+
+        // keyed by hash, the definitions are compared on a hit
+        std::unordered_multimap<uint64_t, set_layout_entry> m_set_layouts;
+        std::unordered_multimap<uint64_t, pipeline_layout_entry> m_pipeline_layouts;
+        mutable std::mutex m_mutex;
+    };
+}
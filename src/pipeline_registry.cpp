@@ -0,0 +1,230 @@
+#include "pipeline_registry.hpp"
+#include "util.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ppr
+{
+    namespace
+    {
+        constexpr uint32_t USAGE_MAGIC = 0x55525050; // "PPRU"
+        constexpr uint32_t USAGE_VERSION = 2;
+
+        struct usage_header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t count;
+        };
+    }
+
+    pipeline_registry::pipeline_registry(const vk::Device& a_device, 
+                                         const pipeline_cache& a_pipeline_cache, 
+                                         shader_module_cache& a_shader_modules, 
+                                         pipeline_layout_cache& a_layouts, 
+                                         pipeline_compiler& a_compiler)
+        : m_device(a_device)
+        , m_pipeline_cache(a_pipeline_cache)
+        , m_shader_modules(a_shader_modules)
+        , m_layouts(a_layouts)
+        , m_compiler(a_compiler)
+    {}
+
+    void pipeline_registry::destroy()
+    {
+        discard(m_pipelines);
+        m_ids.clear();
+        m_used.clear();
+    }
+
+    void pipeline_registry::set_uniform_layout(const vk::DescriptorSetLayout& a_layout)
+    {
+        m_uniform_layout = a_layout;
+    }
+
+    uint32_t pipeline_registry::request(const pipeline_description& a_description)
+    {
+        const auto& constants = a_description.specialization;
+        const auto not_ascending = [](const specialization_constant& a_lhs, const specialization_constant& a_rhs)
+        {
+            return a_lhs.id >= a_rhs.id;
+        };
+
+        // The same constants listed in another order are the same variant. Vulkan takes
+        // each id once, a repeated one keeps its last value as if assigned in order.
+        if (std::adjacent_find(constants.begin(), constants.end(), not_ascending) != constants.end())
+        {
+            std::vector<specialization_constant> sorted = constants;
+            std::stable_sort(sorted.begin(), sorted.end(), [](const specialization_constant& a_lhs, const specialization_constant& a_rhs)
+            {
+                return a_lhs.id < a_rhs.id;
+            });
+
+            pipeline_description merged = a_description;
+            merged.specialization.clear();
+
+            for (size_t i = 0; i < sorted.size(); ++i)
+            {
+                if (i + 1 == sorted.size() || sorted[i + 1].id != sorted[i].id)
+                    merged.specialization.push_back(sorted[i]);
+            }
+
+            return request(merged);
+        }
+
+        std::vector<uint32_t>& ids = m_ids[a_description.hash()];
+
+        for (uint32_t i_id : ids)
+            if (description(i_id) == a_description)
+                return i_id;
+
+        const uint32_t id = static_cast<uint32_t>(m_pipelines.size());
+
+        m_pipelines.push_back(submit(a_description));
+        m_used.push_back(false);
+        ids.push_back(id);
+
+        return id;
+    }
+
+    const pipeline_handle& pipeline_registry::get(uint32_t a_id) const
+    {
+        return m_pipelines[a_id];
+    }
+
+    const pipeline_description& pipeline_registry::description(uint32_t a_id) const
+    {
+        return m_pipelines[a_id]->get().description();
+    }
+
+    uint32_t pipeline_registry::size() const
+    {
+        return static_cast<uint32_t>(m_pipelines.size());
+    }
+
+    void pipeline_registry::rebuild(const vk::RenderPass& a_renderpass, vk::Format a_color_format, deletion_queue& a_deletions)
+    {
+        // the format is part of the hash, so the lookup is rebuilt along with the pipelines
+        m_ids.clear();
+
+        for (uint32_t i = 0; i < m_pipelines.size(); ++i)
+        {
+            pipeline_description rebuilt = description(i);
+            rebuilt.renderpass = a_renderpass;
+            rebuilt.color_format = a_color_format;
+
+            retire(m_pipelines[i], a_deletions);
+
+            m_pipelines[i] = submit(rebuilt);
+            m_ids[rebuilt.hash()].push_back(i);
+        }
+    }
+
+    std::vector<pipeline_handle> pipeline_registry::compile_all() const
+    {
+        std::vector<pipeline_handle> pipelines;
+        pipelines.reserve(m_pipelines.size());
+
+        for (uint32_t i = 0; i < m_pipelines.size(); ++i)
+            pipelines.push_back(submit(description(i)));
+
+        return pipelines;
+    }
+
+    void pipeline_registry::replace(std::vector<pipeline_handle>& a_pipelines, deletion_queue& a_deletions)
+    {
+        const size_t count = std::min(a_pipelines.size(), m_pipelines.size());
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            retire(m_pipelines[i], a_deletions);
+            m_pipelines[i] = std::move(a_pipelines[i]);
+        }
+
+        a_pipelines.clear();
+    }
+
+    void pipeline_registry::discard(std::vector<pipeline_handle>& a_pipelines)
+    {
+        for (auto& i_pipeline : a_pipelines)
+        {
+            if (i_pipeline->discard())
+                i_pipeline->get().destroy();
+        }
+
+        a_pipelines.clear();
+    }
+
+    void pipeline_registry::mark_used(uint32_t a_id)
+    {
+        m_used[a_id] = true;
+    }
+
+    uint32_t pipeline_registry::used_count() const
+    {
+        return static_cast<uint32_t>(std::count(m_used.begin(), m_used.end(), true));
+    }
+
+    bool pipeline_registry::save_usage(const std::string& a_path) const
+    {
+        const usage_header header = { USAGE_MAGIC, USAGE_VERSION, used_count() };
+
+        std::vector<char> data(reinterpret_cast<const char*>(&header), 
+                               reinterpret_cast<const char*>(&header) + sizeof(header));
+
+        for (uint32_t i = 0; i < m_pipelines.size(); ++i)
+            if (m_used[i])
+                description(i).serialize(data);
+
+        return write_file(a_path, data.data(), data.size());
+    }
+
+    bool pipeline_registry::load_usage(const std::string& a_path, std::vector<pipeline_description>& a_descriptions)
+    {
+        std::vector<char> data;
+        if (!read_file(a_path, data) || data.size() < sizeof(usage_header))
+            return false;
+
+        usage_header header;
+        memcpy(&header, data.data(), sizeof(header));
+
+        if (header.magic != USAGE_MAGIC || header.version != USAGE_VERSION)
+        {
+            log->warn("Ignoring pipeline usage file \"{}\" from another version.", a_path);
+            return false;
+        }
+
+        const char* cursor = data.data() + sizeof(header);
+        const char* end = data.data() + data.size();
+
+        // keep whatever parsed before a truncated entry
+        for (uint32_t i = 0; i < header.count; ++i)
+        {
+            pipeline_description description;
+
+            if (!description.deserialize(cursor, end))
+            {
+                log->warn("Pipeline usage file \"{}\" is truncated after {} entries.", a_path, i);
+                break;
+            }
+
+            a_descriptions.push_back(std::move(description));
+        }
+
+        return true;
+    }
+
+    pipeline_handle pipeline_registry::submit(const pipeline_description& a_description) const
+    {
+        return m_compiler.submit(pipeline(m_device, a_description, m_pipeline_cache.get(), m_shader_modules, m_layouts, m_uniform_layout));
+    }
+
+    void pipeline_registry::retire(const pipeline_handle& a_pipeline, deletion_queue& a_deletions) const
+    {
+        // Ones still compiling are dropped by their worker once done, nothing has used them
+        if (a_pipeline->discard())
+            a_deletions.destroy(a_pipeline->get().get());
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "pipeline_compiler.hpp"
+#include "pipeline_description.hpp"
+#include "pipeline_cache.hpp"
+#include "deletion_queue.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ppr
+{
+    // Owns every graphics pipeline and hands out small ids for them. Requesting a
+    // description that was seen before returns the existing id instead of compiling
+    // a duplicate, so draws can also be sorted by id to minimize pipeline binds.
+    // Ids stay valid for the registry's lifetime, including across rebuild() and
+    // replace(), which swap the pipeline behind an id. Nothing is evicted: scenes
+    // switch back and forth between the same few pipelines, and an id that could
+    // be reused would need every draw list and the usage record to forget it.
+    class pipeline_registry
+    {
+    public:
+        pipeline_registry(const vk::Device& a_device, 
+                          const pipeline_cache& a_pipeline_cache, 
+                          shader_module_cache& a_shader_modules, 
+                          pipeline_layout_cache& a_layouts, 
+                          pipeline_compiler& a_compiler);
+
+        // The GPU and the compiler must be done with every pipeline
+        void destroy();
+
+        // Set 0 every pipeline must declare, pipelines requested after this whose shaders
+        // declare something else fail to build and draw with the fallback instead
+        void set_uniform_layout(const vk::DescriptorSetLayout& a_layout);
+
+        // Queues a new description on the compiler, the returned id is usable right
+        // away but its pipeline may not be ready yet
+        uint32_t request(const pipeline_description& a_description);
+
+        const pipeline_handle& get(uint32_t a_id) const;
+        const pipeline_description& description(uint32_t a_id) const;
+        uint32_t size() const;
+
+        // Recompiles every pipeline for a render pass with a different attachment format
+        void rebuild(const vk::RenderPass& a_renderpass, vk::Format a_color_format, deletion_queue& a_deletions);
+
+        // Compiles a fresh copy of every pipeline, in id order. Reads only, so it can
+        // run on another thread as long as nothing modifies the registry meanwhile.
+        std::vector<pipeline_handle> compile_all() const;
+
+        // Takes over the pipelines from compile_all(), the old ones are retired. Ids
+        // requested after compile_all() keep their current pipeline.
+        void replace(std::vector<pipeline_handle>& a_pipelines, deletion_queue& a_deletions);
+
+        // Destroys pipelines no frame has used, without going through a deletion queue
+        static void discard(std::vector<pipeline_handle>& a_pipelines);
+
+        // Usage recording: ids bound by a frame this session are written out on save,
+        // the next startup requests them up front so they compile before they are needed
+        void mark_used(uint32_t a_id);
+        uint32_t used_count() const;
+        bool save_usage(const std::string& a_path) const;
+        static bool load_usage(const std::string& a_path, std::vector<pipeline_description>& a_descriptions);
+
+    private:
+        pipeline_handle submit(const pipeline_description& a_description) const;
+        void retire(const pipeline_handle& a_pipeline, deletion_queue& a_deletions) const;
+
+    private:
+        const vk::Device& m_device;
+        const pipeline_cache& m_pipeline_cache;
+        shader_module_cache& m_shader_modules;
+        pipeline_layout_cache& m_layouts;
+        pipeline_compiler& m_compiler;
+        vk::DescriptorSetLayout m_uniform_layout;
+
+        std::vector<pipeline_handle> m_pipelines; // indexed by id
+        std::vector<bool> m_used;                 // render thread only
+
+        // hash to ids, more than one only on a hash collision
+        std::unordered_map<uint64_t, std::vector<uint32_t>> m_ids;
+    };
+}
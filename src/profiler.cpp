@@ -0,0 +1,172 @@
+#include "profiler.hpp"
+#include "util.hpp"
+#include "logger.hpp"
+
+#include <cstring>
+
+namespace ppr
+{
+    constexpr uint32_t profiler::MAX_SCOPES_PER_FRAME;
+    constexpr uint32_t profiler::INVALID_SCOPE;
+
+    double profiler_report::milliseconds(const char* a_name) const
+    {
+        for (const auto& i_scope : scopes)
+        {
+            if (std::strcmp(i_scope.name, a_name) == 0)
+                return i_scope.milliseconds;
+        }
+
+        return 0.0;
+    }
+
+    profiler::scope::scope(profiler& a_profiler, const vk::CommandBuffer& a_commandbuffer, const char* a_name)
+        : m_profiler(a_profiler)
+        , m_commandbuffer(a_commandbuffer)
+        , m_index(a_profiler.begin_scope(a_commandbuffer, a_name))
+    {}
+
+    profiler::scope::~scope()
+    {
+        m_profiler.end_scope(m_commandbuffer, m_index);
+    }
+
+    profiler::profiler(const vk::Device& a_device, const vk::PhysicalDevice& a_physical_device)
+        : m_device(a_device)
+        , m_physical_device(a_physical_device)
+        , m_timestamp_period(0.0)
+        , m_timestamp_mask(0)
+        , m_current_frame(0)
+        , m_depth(0)
+    {}
+
+    void profiler::init(uint32_t a_frames_in_flight, uint32_t a_queue_family)
+    {
+        log->trace("Initializing GPU profiler...");
+
+        const uint32_t valid_bits = m_physical_device.getQueueFamilyProperties()[a_queue_family].timestampValidBits;
+
+        if (valid_bits == 0)
+        {
+            log->warn("Queue family {} does not support timestamps, GPU profiling is disabled.", a_queue_family);
+            return;
+        }
+
+        m_timestamp_period = m_physical_device.getProperties().limits.timestampPeriod;
+        m_timestamp_mask = valid_bits >= 64 ? UINT64_MAX : (uint64_t(1) << valid_bits) - 1;
+
+        m_frames.resize(a_frames_in_flight);
+        m_timestamps.resize(MAX_SCOPES_PER_FRAME * 2);
+
+        const vk::QueryPoolCreateInfo querypool_createinfo({}, vk::QueryType::eTimestamp, 
+                                                           a_frames_in_flight * MAX_SCOPES_PER_FRAME * 2);
+        m_querypool = m_device.createQueryPool(querypool_createinfo);
+
+        log->debug("GPU profiler initialized, timestamp period: {} ns.", m_timestamp_period);
+    }
+
+    void profiler::destroy()
+    {
+        if (m_querypool)
+            m_device.destroyQueryPool(m_querypool);
+
+        m_querypool = nullptr;
+    }
+
+    bool profiler::is_enabled() const
+    {
+        return m_querypool;
+    }
+
+    void profiler::begin_frame(const frame_context& a_frame)
+    {
+        if (!is_enabled())
+            return;
+
+        resolve(a_frame.index);
+
+        m_current_frame = a_frame.index;
+        m_depth = 0;
+        m_frames[m_current_frame].frame_number = a_frame.number;
+
+        a_frame.commandbuffer.resetQueryPool(m_querypool, 
+                                             m_current_frame * MAX_SCOPES_PER_FRAME * 2, 
+                                             MAX_SCOPES_PER_FRAME * 2);
+    }
+
+    const profiler_report& profiler::frame_report() const
+    {
+        return m_report;
+    }
+
+    uint32_t profiler::begin_scope(const vk::CommandBuffer& a_commandbuffer, const char* a_name)
+    {
+        if (!is_enabled())
+            return INVALID_SCOPE;
+
+        std::vector<recorded_scope>& scopes = m_frames[m_current_frame].scopes;
+
+        if (scopes.size() >= MAX_SCOPES_PER_FRAME)
+        {
+            log->warn("More than {} profiler scopes in a frame, \"{}\" is not timed.", MAX_SCOPES_PER_FRAME, a_name);
+            return INVALID_SCOPE;
+        }
+
+        const uint32_t index = static_cast<uint32_t>(scopes.size());
+        scopes.push_back({ a_name, m_depth++ });
+
+        a_commandbuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, m_querypool, 
+                                       (m_current_frame * MAX_SCOPES_PER_FRAME + index) * 2);
+        return index;
+    }
+
+    void profiler::end_scope(const vk::CommandBuffer& a_commandbuffer, uint32_t a_index)
+    {
+        if (a_index == INVALID_SCOPE)
+            return;
+
+        --m_depth;
+
+        a_commandbuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, m_querypool, 
+                                       (m_current_frame * MAX_SCOPES_PER_FRAME + a_index) * 2 + 1);
+    }
+
+    void profiler::resolve(uint32_t a_frame_index)
+    {
+        frame_scopes& frame = m_frames[a_frame_index];
+
+        if (frame.scopes.empty())
+            return;
+
+        const uint32_t query_count = static_cast<uint32_t>(frame.scopes.size()) * 2;
+
+        // No wait flag: the slot's submission has retired, and if it somehow has not
+        // we would rather drop a report than stall the frame
+        const vk::Result result = m_device.getQueryPoolResults(m_querypool, 
+                                                               a_frame_index * MAX_SCOPES_PER_FRAME * 2, 
+                                                               query_count, 
+                                                               query_count * sizeof(uint64_t), 
+                                                               m_timestamps.data(), 
+                                                               sizeof(uint64_t), 
+                                                               vk::QueryResultFlagBits::e64);
+
+        if (result == vk::Result::eSuccess)
+        {
+            m_report.frame_number = frame.frame_number;
+            m_report.scopes.clear();
+
+            for (size_t i = 0; i < frame.scopes.size(); ++i)
+            {
+                const uint64_t ticks = (m_timestamps[i * 2 + 1] - m_timestamps[i * 2]) & m_timestamp_mask;
+
+                m_report.scopes.push_back({ frame.scopes[i].name, 
+                                            frame.scopes[i].depth, 
+                                            ticks * m_timestamp_period / 1e6 });
+            }
+
+            m_report.valid = true;
+        }
+
+        frame.scopes.clear();
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "vulkan_structs.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <vector>
+
+namespace ppr
+{
+    struct scope_timing
+    {
+        const char* name;
+        uint32_t depth;          // nesting level, 0 for outermost scopes
+        double milliseconds;
+    };
+
+    // GPU times of every scope recorded in a single frame, in recording order
+    struct profiler_report
+    {
+        uint64_t frame_number = 0;
+        std::vector<scope_timing> scopes;
+        bool valid = false;
+
+        // 0 if no scope of that name was recorded
+        double milliseconds(const char* a_name) const;
+    };
+
+    // Timestamp query profiler with one query range per frame in flight.
+    // Results are read once a frame slot comes around again, at which point its
+    // previous submission has retired, so reading them never waits on the GPU.
+    class profiler
+    {
+    public:
+        // Brackets the commands recorded during its lifetime with timestamps
+        class scope
+        {
+        public:
+            scope(profiler& a_profiler, const vk::CommandBuffer& a_commandbuffer, const char* a_name);
+            ~scope();
+
+            scope(const scope&) = delete;
+            scope& operator=(const scope&) = delete;
+
+        private:
+            profiler& m_profiler;
+            const vk::CommandBuffer& m_commandbuffer;
+            const uint32_t m_index;
+        };
+
+    public:
+        profiler(const vk::Device& a_device, const vk::PhysicalDevice& a_physical_device);
+
+        void init(uint32_t a_frames_in_flight, uint32_t a_queue_family);
+        void destroy();
+
+        // Resolves the results left in this frame's slot and resets its queries.
+        // Must be recorded before any scope of the frame, outside a render pass.
+        void begin_frame(const frame_context& a_frame);
+
+        // Scopes of the most recently retired frame
+        const profiler_report& frame_report() const;
+
+        bool is_enabled() const;
+
+    private:
+        uint32_t begin_scope(const vk::CommandBuffer& a_commandbuffer, const char* a_name);
+        void end_scope(const vk::CommandBuffer& a_commandbuffer, uint32_t a_index);
+
+        void resolve(uint32_t a_frame_index);
+
+    private:
+        static constexpr uint32_t MAX_SCOPES_PER_FRAME = 64;
+        static constexpr uint32_t INVALID_SCOPE = UINT32_MAX;
+
+        struct recorded_scope
+        {
+            const char* name;
+            uint32_t depth;
+        };
+
+        struct frame_scopes
+        {
+            uint64_t frame_number = 0;
+            std::vector<recorded_scope> scopes; // scope i owns queries 2i and 2i + 1
+        };
+
+        const vk::Device& m_device;
+        const vk::PhysicalDevice& m_physical_device;
+
+        vk::QueryPool m_querypool;
+        double m_timestamp_period;   // nanoseconds per tick
+        uint64_t m_timestamp_mask;   // queues may write fewer than 64 valid bits
+
+        std::vector<frame_scopes> m_frames;
+        uint32_t m_current_frame;
+        uint32_t m_depth;
+
+        std::vector<uint64_t> m_timestamps; // readback scratch space
+        profiler_report m_report;
+    };
+}
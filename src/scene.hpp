@@ -0,0 +1,47 @@
+// Description of what the renderer draws each frame
+
+#pragma once
+
+#include "vertex.hpp"
+#include "pipeline_description.hpp"
+
+#include <glm/mat4x4.hpp>
+
+#include <vector>
+
+namespace ppr
+{
+    struct draw_call
+    {
+        uint32_t index_count;
+        uint32_t first_index;
+        int32_t vertex_offset;
+        uint32_t pipeline_index; // into scene::pipelines
+
+        glm::mat4 transform = glm::mat4(1.f);
+    };
+
+    // Uniform data as laid out in the shaders (std140), one copy per frame
+    struct frame_uniforms
+    {
+        glm::mat4 view_projection;
+    };
+
+    // ...and one per draw
+    struct draw_uniforms
+    {
+        glm::mat4 model;
+    };
+
+    struct scene
+    {
+        std::vector<vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<draw_call> draws;
+
+        // Render pass and format are filled in by the renderer, the layout is reflected from
+        // the shaders. Identical descriptions share one pipeline. Empty means every draw
+        // uses the default.
+        std::vector<pipeline_description> pipelines;
+    };
+}
@@ -0,0 +1,250 @@
+#include "shader_compiler.hpp"
+#include "util.hpp"
+#include "logger.hpp"
+
+#ifdef PPR_SHADERC
+#include <shaderc/shaderc.hpp>
+#endif
+
+#include <chrono>
+
+namespace ppr
+{
+    namespace
+    {
+        // Bump when compile options change, it invalidates every cached binary
+        constexpr uint32_t OPTIONS_VERSION = 1;
+        constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+#ifdef PPR_DEBUG
+        constexpr bool GENERATE_DEBUG_INFO = true;
+#else
+        constexpr bool GENERATE_DEBUG_INFO = false;
+#endif
+
+#ifdef PPR_SHADERC
+        shaderc_shader_kind to_shader_kind(vk::ShaderStageFlagBits a_stage)
+        {
+            switch (a_stage)
+            {
+            case vk::ShaderStageFlagBits::eVertex:                 return shaderc_vertex_shader;
+            case vk::ShaderStageFlagBits::eFragment:               return shaderc_fragment_shader;
+            case vk::ShaderStageFlagBits::eGeometry:               return shaderc_geometry_shader;
+            case vk::ShaderStageFlagBits::eTessellationControl:    return shaderc_tess_control_shader;
+            case vk::ShaderStageFlagBits::eTessellationEvaluation: return shaderc_tess_evaluation_shader;
+            case vk::ShaderStageFlagBits::eCompute:                return shaderc_compute_shader;
+            default:                                               return shaderc_glsl_infer_from_source;
+            }
+        }
+#endif
+    }
+
+    spirv_binary::spirv_binary(mapped_file&& a_file)
+        : m_file(std::move(a_file))
+    {}
+
+    spirv_binary::spirv_binary(std::vector<uint32_t>&& a_words)
+        : m_words(std::move(a_words))
+    {}
+
+    const uint32_t* spirv_binary::data() const
+    {
+        return m_file.is_open() ? static_cast<const uint32_t*>(m_file.data()) : m_words.data();
+    }
+
+    size_t spirv_binary::size() const
+    {
+        return m_file.is_open() ? m_file.size() : m_words.size() * sizeof(uint32_t);
+    }
+
+    bool spirv_binary::empty() const
+    {
+        return size() == 0;
+    }
+
+    shader_compiler::shader_compiler(const std::string& a_cache_dir)
+        : m_cache_dir(a_cache_dir)
+    {}
+
+    void shader_compiler::init()
+    {
+        if (!make_directory(m_cache_dir))
+            log->warn("Failed to create shader cache directory \"{}\", compiled shaders won't persist.", m_cache_dir);
+    }
+
+    bool shader_compiler::load_source(const std::string& a_path, 
+                                      vk::ShaderStageFlagBits a_stage, 
+                                      const std::vector<shader_define>& a_defines, 
+                                      shader_source& a_source) const
+    {
+        std::vector<char> source_bytes;
+        if (!read_file(a_path, source_bytes))
+        {
+            log->error("Failed to open shader \"{}\".", a_path);
+            return false;
+        }
+
+        a_source.path = a_path;
+        a_source.text.assign(source_bytes.begin(), source_bytes.end());
+        a_source.stage = a_stage;
+        a_source.defines = a_defines;
+        a_source.key = cache_key(a_source.text, a_stage, a_defines);
+
+        return true;
+    }
+
+    spirv_binary shader_compiler::compile(const shader_source& a_source)
+    {
+        // One thread per entry, so two callers never write the same cache file. A second
+        // caller waits for the first and then maps what it wrote.
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_entry_done.wait(lock, [&]() { return m_compiling.count(a_source.key) == 0; });
+            m_compiling.insert(a_source.key);
+        }
+
+        spirv_binary binary = compile_entry(a_source);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_compiling.erase(a_source.key);
+        }
+        m_entry_done.notify_all();
+
+        return binary;
+    }
+
+    spirv_binary shader_compiler::compile_entry(const shader_source& a_source) const
+    {
+        const std::string cache_path = m_cache_dir + "/" + to_hex(a_source.key) + ".spv";
+        mapped_file cached;
+
+        if (load_cached(cache_path, cached))
+        {
+            log->trace("Mapped cached SPIR-V for \"{}\" ({}).", a_source.path, to_hex(a_source.key));
+
+            return spirv_binary(std::move(cached));
+        }
+
+#ifdef PPR_SHADERC
+        std::vector<uint32_t> spirv = invoke_compiler(a_source.path, a_source.text, a_source.stage, a_source.defines);
+
+        if (spirv.empty())
+            return {};
+
+        if (!write_file(cache_path, spirv.data(), spirv.size() * sizeof(uint32_t)))
+            log->warn("Failed to write shader cache entry \"{}\".", cache_path);
+
+        return spirv_binary(std::move(spirv));
+#else
+        return load_precompiled(a_source);
+#endif
+    }
+
+    uint64_t shader_compiler::cache_key(const std::string& a_source, 
+                                        vk::ShaderStageFlagBits a_stage, 
+                                        const std::vector<shader_define>& a_defines) const
+    {
+        unsigned int spirv_version = 0;
+        unsigned int spirv_revision = 0;
+#ifdef PPR_SHADERC
+        shaderc_get_spv_version(&spirv_version, &spirv_revision);
+#endif
+
+        const uint32_t stage = static_cast<uint32_t>(a_stage);
+
+        uint64_t hash = hash_string(a_source);
+        hash = hash_bytes(&stage, sizeof(stage), hash);
+        hash = hash_bytes(&OPTIONS_VERSION, sizeof(OPTIONS_VERSION), hash);
+        hash = hash_bytes(&GENERATE_DEBUG_INFO, sizeof(GENERATE_DEBUG_INFO), hash);
+        hash = hash_bytes(&spirv_version, sizeof(spirv_version), hash);
+        hash = hash_bytes(&spirv_revision, sizeof(spirv_revision), hash);
+
+        for (const auto& i_define : a_defines)
+        {
+            hash = hash_string(i_define.name, hash);
+            hash = hash_string(i_define.value, hash);
+        }
+
+        return hash;
+    }
+
+    bool shader_compiler::load_cached(const std::string& a_path, mapped_file& a_file) const
+    {
+        if (!a_file.open(a_path))
+            return false;
+
+        // a truncated or foreign file is treated as a miss and overwritten
+        if (a_file.size() < sizeof(uint32_t) || a_file.size() % sizeof(uint32_t) != 0
+            || *static_cast<const uint32_t*>(a_file.data()) != SPIRV_MAGIC)
+        {
+            a_file.close();
+            return false;
+        }
+
+        return true;
+    }
+
+#ifdef PPR_SHADERC
+    std::vector<uint32_t> shader_compiler::invoke_compiler(const std::string& a_path, 
+                                                           const std::string& a_source, 
+                                                           vk::ShaderStageFlagBits a_stage, 
+                                                           const std::vector<shader_define>& a_defines) const
+    {
+        log->debug("Compiling shader \"{}\"...", a_path);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        shaderc::CompileOptions options;
+        options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_1);
+        options.SetOptimizationLevel(shaderc_optimization_level_performance);
+
+        if (GENERATE_DEBUG_INFO)
+            options.SetGenerateDebugInfo();
+
+        for (const auto& i_define : a_defines)
+            options.AddMacroDefinition(i_define.name, i_define.value);
+
+        const shaderc::Compiler compiler;
+        const shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(a_source, 
+                                                                               to_shader_kind(a_stage), 
+                                                                               a_path.c_str(), 
+                                                                               options);
+
+        if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+        {
+            log->error("Failed to compile shader \"{}\":\n{}", a_path, result.GetErrorMessage());
+            return {};
+        }
+
+        if (result.GetNumWarnings() > 0)
+            log->warn("Shader \"{}\" compiled with warnings:\n{}", a_path, result.GetErrorMessage());
+
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        log->debug("Compiled \"{}\" in {:.2f} ms.", a_path, elapsed.count());
+
+        return std::vector<uint32_t>(result.cbegin(), result.cend());
+    }
+#else
+    spirv_binary shader_compiler::load_precompiled(const shader_source& a_source) const
+    {
+        // glslc has to have compiled each source ahead of time, e.g. shader.vert to shader.vert.spv
+        if (!a_source.defines.empty())
+        {
+            log->error("Shader \"{}\" has defines, they need a build with PPR_SHADERC.", a_source.path);
+            return {};
+        }
+
+        const std::string path = a_source.path + ".spv";
+        mapped_file file;
+
+        if (!load_cached(path, file))
+        {
+            log->error("Failed to load precompiled shader \"{}\", this build can't compile GLSL.", path);
+            return {};
+        }
+
+        return spirv_binary(std::move(file));
+    }
+#endif
+}
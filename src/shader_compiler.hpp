@@ -0,0 +1,95 @@
+#pragma once
+
+#include "mapped_file.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace ppr
+{
+    struct shader_define
+    {
+        std::string name;
+        std::string value;
+    };
+
+    struct shader_source
+    {
+        std::string path;
+        std::string text;
+        vk::ShaderStageFlagBits stage;
+        std::vector<shader_define> defines;
+        uint64_t key; // hash of everything that affects the binary
+    };
+
+    // SPIR-V words, either mapped straight from the disk cache or owned after a fresh compile
+    class spirv_binary
+    {
+    public:
+        spirv_binary() = default;
+        explicit spirv_binary(mapped_file&& a_file);
+        explicit spirv_binary(std::vector<uint32_t>&& a_words);
+
+        const uint32_t* data() const;
+        size_t size() const; // in bytes, as vk::ShaderModuleCreateInfo wants it
+        bool empty() const;
+
+    private:
+        mapped_file m_file;
+        std::vector<uint32_t> m_words;
+    };
+
+    // Compiles GLSL to SPIR-V at runtime with shaderc. Results are cached on disk
+    // under a hash of the source text, stage, defines and compiler options, so a
+    // warm start loads the binaries without invoking the compiler, and an edit to
+    // any of them produces a new entry instead of a stale hit.
+    //
+    // shaderc is only linked when PPR_SHADERC is defined. Without it, sources are
+    // loaded from a .spv compiled next to each of them ahead of time.
+    class shader_compiler
+    {
+    public:
+        explicit shader_compiler(const std::string& a_cache_dir);
+
+        void init();
+
+        // Reads the source and computes its cache key, false if it can't be read
+        bool load_source(const std::string& a_path, 
+                         vk::ShaderStageFlagBits a_stage, 
+                         const std::vector<shader_define>& a_defines, 
+                         shader_source& a_source) const;
+
+        // Returns an empty binary when the source fails to compile
+        spirv_binary compile(const shader_source& a_source);
+
+    private:
+        uint64_t cache_key(const std::string& a_source, 
+                           vk::ShaderStageFlagBits a_stage, 
+                           const std::vector<shader_define>& a_defines) const;
+
+        bool load_cached(const std::string& a_path, mapped_file& a_file) const;
+
+        spirv_binary compile_entry(const shader_source& a_source) const;
+
+#ifdef PPR_SHADERC
+        std::vector<uint32_t> invoke_compiler(const std::string& a_path, 
+                                              const std::string& a_source, 
+                                              vk::ShaderStageFlagBits a_stage, 
+                                              const std::vector<shader_define>& a_defines) const;
+#else
+        spirv_binary load_precompiled(const shader_source& a_source) const;
+#endif
+
+    private:
+        const std::string m_cache_dir;
+
+        std::mutex m_mutex;
+        std::condition_variable m_entry_done;
+        std::set<uint64_t> m_compiling; // keys of the entries being compiled
+    };
+}
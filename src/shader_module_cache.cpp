@@ -0,0 +1,87 @@
+#include "shader_module_cache.hpp"
+#include "util.hpp"
+#include "logger.hpp"
+
+namespace ppr
+{
+    shader_module_cache::shader_module_cache(const vk::Device& a_device, shader_compiler& a_compiler)
+        : m_device(a_device)
+        , m_compiler(a_compiler)
+    {}
+
+    void shader_module_cache::destroy()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (const auto& i_entry : m_modules)
+            m_device.destroyShaderModule(i_entry.second->module);
+
+        m_modules.clear();
+    }
+
+    shader_module_ref shader_module_cache::acquire(const std::string& a_path, 
+                                                   vk::ShaderStageFlagBits a_stage, 
+                                                   const std::vector<shader_define>& a_defines)
+    {
+        // the source is read on every call, it's small and its hash is what detects edits
+        shader_source source;
+        if (!m_compiler.load_source(a_path, a_stage, a_defines, source))
+            return nullptr;
+
+        // the same text under two paths still gets two modules, their debug names differ
+        const uint64_t key = hash_string(a_path, source.key);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const auto found = m_modules.find(key);
+        if (found != m_modules.end())
+            return found->second;
+
+        const spirv_binary spirv = m_compiler.compile(source);
+
+        if (spirv.empty())
+            return nullptr;
+
+        auto module = std::make_shared<shader_module>();
+
+        if (!reflect_spirv(spirv.data(), spirv.size(), a_stage, module->reflection))
+        {
+            log->error("Failed to reflect SPIR-V of \"{}\".", a_path);
+            return nullptr;
+        }
+
+        // reads straight from the mapped cache file on a warm start
+        const vk::ShaderModuleCreateInfo createinfo({}, spirv.size(), spirv.data());
+        module->module = m_device.createShaderModule(createinfo);
+        module->stage = a_stage;
+        module->path = a_path;
+        module->key = key;
+
+        log->trace("Created shader module for \"{}\" ({}).", a_path, to_hex(key));
+
+        m_modules.emplace(key, module);
+        return module;
+    }
+
+    void shader_module_cache::trim()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (auto i_entry = m_modules.begin(); i_entry != m_modules.end(); )
+        {
+            if (i_entry->second.use_count() == 1)
+            {
+                m_device.destroyShaderModule(i_entry->second->module);
+                i_entry = m_modules.erase(i_entry);
+            }
+            else
+                ++i_entry;
+        }
+    }
+
+    size_t shader_module_cache::size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_modules.size();
+    }
+}
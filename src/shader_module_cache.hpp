@@ -0,0 +1,58 @@
+#pragma once
+
+#include "shader_compiler.hpp"
+#include "spirv_reflection.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ppr
+{
+    struct shader_module
+    {
+        vk::ShaderModule module;
+        vk::ShaderStageFlagBits stage;
+        std::string path;
+        uint64_t key;
+
+        shader_reflection reflection; // parsed once, when the module is created
+    };
+
+    // Shared by every pipeline built from the same source, stage and defines
+    using shader_module_ref = std::shared_ptr<const shader_module>;
+
+    // Hands out refcounted vk::ShaderModules keyed by path and content hash, so
+    // pipeline rebuilds and variants reuse modules instead of recreating them.
+    // An edited source hashes differently and gets a fresh module, the stale one
+    // is released by trim() once no pipeline holds it anymore.
+    class shader_module_cache
+    {
+    public:
+        shader_module_cache(const vk::Device& a_device, shader_compiler& a_compiler);
+
+        void destroy();
+
+        // Thread-safe. Returns null if the shader can't be read, compiled or reflected.
+        shader_module_ref acquire(const std::string& a_path, 
+                                  vk::ShaderStageFlagBits a_stage, 
+                                  const std::vector<shader_define>& a_defines = {});
+
+        // Destroys modules no pipeline references. Pipelines don't need their
+        // modules after creation, so this is safe while they are in flight.
+        void trim();
+
+        size_t size() const;
+
+    private:
+        const vk::Device& m_device;
+        shader_compiler& m_compiler;
+
+        std::unordered_map<uint64_t, std::shared_ptr<shader_module>> m_modules;
+        mutable std::mutex m_mutex;
+    };
+}
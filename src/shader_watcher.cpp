@@ -0,0 +1,212 @@
+#include "shader_watcher.hpp"
+#include "logger.hpp"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <chrono>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <set>
+#endif
+
+namespace ppr
+{
+    constexpr int shader_watcher::POLL_INTERVAL_MS;
+    constexpr int shader_watcher::DEBOUNCE_MS;
+
+    namespace
+    {
+        std::string directory_of(const std::string& a_path)
+        {
+            const size_t slash = a_path.find_last_of("/\\");
+            return slash == std::string::npos ? "." : a_path.substr(0, slash);
+        }
+
+        std::string filename_of(const std::string& a_path)
+        {
+            const size_t slash = a_path.find_last_of("/\\");
+            return slash == std::string::npos ? a_path : a_path.substr(slash + 1);
+        }
+    }
+
+    shader_watcher::shader_watcher(const std::vector<std::string>& a_paths)
+        : m_paths(a_paths)
+        , m_running(false)
+        , m_inotify_fd(-1)
+    {}
+
+    shader_watcher::~shader_watcher()
+    {
+        stop();
+    }
+
+    void shader_watcher::start(std::function<void()> a_on_change)
+    {
+        if (m_running)
+            return;
+
+        m_on_change = std::move(a_on_change);
+
+        if (open_inotify())
+            log->debug("Watching {} shader sources with inotify.", m_paths.size());
+        else
+        {
+            m_mtimes.clear();
+            for (const auto& i_path : m_paths)
+                m_mtimes.push_back(modification_time(i_path));
+
+            log->debug("Polling {} shader sources for changes every {} ms.", m_paths.size(), POLL_INTERVAL_MS);
+        }
+
+        m_running = true;
+        m_thread = std::thread(&shader_watcher::run, this);
+    }
+
+    void shader_watcher::stop()
+    {
+        if (!m_running)
+            return;
+
+        m_running = false;
+
+        if (m_thread.joinable())
+            m_thread.join();
+
+        close_inotify();
+    }
+
+    bool shader_watcher::is_running() const
+    {
+        return m_running;
+    }
+
+    void shader_watcher::run()
+    {
+        while (m_running)
+        {
+            // both wait at most POLL_INTERVAL_MS, so stop() is noticed promptly
+            const bool changed = m_inotify_fd >= 0 ? wait_inotify() : poll_mtimes();
+
+            if (!changed || !m_running)
+                continue;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(DEBOUNCE_MS));
+
+            // swallow the rest of a multi-write save
+            if (m_inotify_fd >= 0)
+                while (wait_inotify()) {}
+            else
+                poll_mtimes();
+
+            log->info("Shader sources changed, rebuilding...");
+            m_on_change();
+        }
+    }
+
+#ifdef __linux__
+    bool shader_watcher::open_inotify()
+    {
+        m_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+        if (m_inotify_fd < 0)
+            return false;
+
+        // Editors commonly replace files instead of writing in place, so the
+        // directories are watched rather than the files themselves
+        std::set<std::string> directories;
+        for (const auto& i_path : m_paths)
+            directories.insert(directory_of(i_path));
+
+        for (const auto& i_directory : directories)
+        {
+            if (inotify_add_watch(m_inotify_fd, i_directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+            {
+                log->warn("Failed to watch \"{}\", falling back to polling.", i_directory);
+                close_inotify();
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool shader_watcher::wait_inotify()
+    {
+        pollfd descriptor = { m_inotify_fd, POLLIN, 0 };
+
+        if (poll(&descriptor, 1, POLL_INTERVAL_MS) <= 0)
+            return false;
+
+        alignas(inotify_event) char events[4096];
+        const ssize_t length = read(m_inotify_fd, events, sizeof(events));
+
+        bool changed = false;
+
+        for (ssize_t offset = 0; offset < length; )
+        {
+            const auto event = reinterpret_cast<const inotify_event*>(events + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            if (event->len == 0)
+                continue;
+
+            for (const auto& i_path : m_paths)
+                changed = changed || filename_of(i_path) == event->name;
+        }
+
+        return changed;
+    }
+
+    void shader_watcher::close_inotify()
+    {
+        if (m_inotify_fd >= 0)
+            close(m_inotify_fd);
+
+        m_inotify_fd = -1;
+    }
+#else
+    bool shader_watcher::open_inotify()
+    { return false; }
+
+    bool shader_watcher::wait_inotify()
+    { return false; }
+
+    void shader_watcher::close_inotify()
+    {}
+#endif
+
+    bool shader_watcher::poll_mtimes()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+
+        bool changed = false;
+
+        for (size_t i = 0; i < m_paths.size(); ++i)
+        {
+            const std::time_t mtime = modification_time(m_paths[i]);
+
+            if (mtime != m_mtimes[i])
+            {
+                m_mtimes[i] = mtime;
+                changed = true;
+            }
+        }
+
+        return changed;
+    }
+
+    std::time_t shader_watcher::modification_time(const std::string& a_path) const
+    {
+        struct stat info;
+
+        if (stat(a_path.c_str(), &info) != 0)
+            return 0;
+
+        return info.st_mtime;
+    }
+}
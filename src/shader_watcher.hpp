@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ppr
+{
+    // Watches shader sources on a worker thread and runs a callback there
+    // whenever one of them changes. Uses inotify on Linux and falls back to
+    // polling modification times elsewhere. The callback runs on the worker,
+    // so it may block (compiling, building pipelines) without stalling the
+    // render loop.
+    class shader_watcher
+    {
+    public:
+        explicit shader_watcher(const std::vector<std::string>& a_paths);
+        ~shader_watcher();
+
+        shader_watcher(const shader_watcher&) = delete;
+        shader_watcher& operator=(const shader_watcher&) = delete;
+
+        void start(std::function<void()> a_on_change);
+        void stop();
+
+        bool is_running() const;
+
+    private:
+        void run();
+
+        bool open_inotify();
+        bool wait_inotify();
+        void close_inotify();
+
+        bool poll_mtimes();
+        std::time_t modification_time(const std::string& a_path) const;
+
+    private:
+        static constexpr int POLL_INTERVAL_MS = 250;
+        static constexpr int DEBOUNCE_MS = 50; // editors often save in several writes
+
+        const std::vector<std::string> m_paths;
+
+        std::function<void()> m_on_change;
+        std::thread m_thread;
+        std::atomic<bool> m_running;
+
+        int m_inotify_fd;
+        std::vector<std::time_t> m_mtimes;
+    };
+}
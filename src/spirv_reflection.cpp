@@ -0,0 +1,402 @@
+#include "spirv_reflection.hpp"
+#include "logger.hpp"
+
+#include <vulkan/spirv.hpp>
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace ppr
+{
+    namespace
+    {
+        constexpr uint32_t UNSET = UINT32_MAX;
+        constexpr size_t HEADER_WORDS = 5;
+
+        // What a single pass over the binary learns about one result id
+        struct id_info
+        {
+            spv::Op opcode = spv::OpNop;
+            std::vector<uint32_t> operands; // the instruction's words after the result id
+
+            uint32_t set = UNSET;
+            uint32_t binding = UNSET;
+            uint32_t location = UNSET;
+            uint32_t array_stride = 0;
+            uint32_t spec_id = UNSET;
+            bool block = false;
+            bool buffer_block = false;
+            bool builtin = false;
+
+            std::vector<uint32_t> member_offsets;
+        };
+
+        class spirv_parser
+        {
+        public:
+            bool parse(const uint32_t* a_words, size_t a_count)
+            {
+                if (a_count < HEADER_WORDS || a_words[0] != spv::MagicNumber)
+                    return false;
+
+                for (size_t i = HEADER_WORDS; i < a_count; )
+                {
+                    const uint32_t word_count = a_words[i] >> 16;
+                    const spv::Op opcode = static_cast<spv::Op>(a_words[i] & 0xFFFF);
+
+                    if (word_count == 0 || i + word_count > a_count)
+                        return false;
+
+                    read_instruction(opcode, a_words + i + 1, word_count - 1);
+                    i += word_count;
+                }
+
+                return true;
+            }
+
+            const std::unordered_map<uint32_t, id_info>& ids() const
+            { return m_ids; }
+
+            const id_info* find(uint32_t a_id) const
+            {
+                const auto found = m_ids.find(a_id);
+                return found == m_ids.end() ? nullptr : &found->second;
+            }
+
+            // Byte size as laid out in the binary, following explicit offsets and strides
+            uint32_t size_of(uint32_t a_type) const
+            {
+                const id_info* type = find(a_type);
+                if (!type)
+                    return 0;
+
+                const auto& ops = type->operands;
+
+                switch (type->opcode)
+                {
+                case spv::OpTypeBool:
+                    return 4;
+                case spv::OpTypeInt:
+                case spv::OpTypeFloat:
+                    return ops[0] / 8;
+                case spv::OpTypeVector:
+                case spv::OpTypeMatrix:
+                    return size_of(ops[0]) * ops[1];
+                case spv::OpTypeArray:
+                {
+                    const uint32_t stride = type->array_stride ? type->array_stride : size_of(ops[0]);
+                    return stride * constant_value(ops[1]);
+                }
+                case spv::OpTypeStruct:
+                {
+                    // the end of the member furthest in, std140/std430 offsets are explicit
+                    uint32_t size = 0;
+                    for (size_t i = 0; i < ops.size(); ++i)
+                    {
+                        const uint32_t offset = i < type->member_offsets.size() ? type->member_offsets[i] : 0;
+                        size = std::max(size, offset + size_of(ops[i]));
+                    }
+                    return size;
+                }
+                default:
+                    return 0;
+                }
+            }
+
+            uint32_t constant_value(uint32_t a_id) const
+            {
+                const id_info* constant = find(a_id);
+                return constant && constant->opcode == spv::OpConstant && constant->operands.size() > 1 
+                     ? constant->operands[1] : 1;
+            }
+
+        private:
+            void read_instruction(spv::Op a_opcode, const uint32_t* a_operands, uint32_t a_count)
+            {
+                switch (a_opcode)
+                {
+                case spv::OpDecorate:
+                    if (a_count >= 2)
+                        decorate(m_ids[a_operands[0]], static_cast<spv::Decoration>(a_operands[1]), 
+                                 a_count > 2 ? a_operands[2] : 0);
+                    break;
+
+                case spv::OpMemberDecorate:
+                    if (a_count >= 4 && a_operands[2] == spv::DecorationOffset)
+                    {
+                        auto& offsets = m_ids[a_operands[0]].member_offsets;
+                        if (offsets.size() <= a_operands[1])
+                            offsets.resize(a_operands[1] + 1, 0);
+                        offsets[a_operands[1]] = a_operands[3];
+                    }
+                    else if (a_count >= 3 && a_operands[2] == spv::DecorationBuiltIn)
+                        m_ids[a_operands[0]].builtin = true;
+                    break;
+
+                // types: result id first
+                case spv::OpTypeBool:
+                case spv::OpTypeInt:
+                case spv::OpTypeFloat:
+                case spv::OpTypeVector:
+                case spv::OpTypeMatrix:
+                case spv::OpTypeImage:
+                case spv::OpTypeSampler:
+                case spv::OpTypeSampledImage:
+                case spv::OpTypeArray:
+                case spv::OpTypeRuntimeArray:
+                case spv::OpTypeStruct:
+                case spv::OpTypePointer:
+                    if (a_count >= 1)
+                        define(a_operands[0], a_opcode, a_operands + 1, a_count - 1);
+                    break;
+
+                // values: result type first, then result id
+                case spv::OpConstant:
+                case spv::OpVariable:
+                    if (a_count >= 2)
+                    {
+                        // keep the type as operand 0 so both are at hand
+                        std::vector<uint32_t> operands(a_operands, a_operands + a_count);
+                        operands.erase(operands.begin() + 1);
+                        define(a_operands[1], a_opcode, operands.data(), static_cast<uint32_t>(operands.size()));
+                    }
+                    break;
+
+                default:
+                    break;
+                }
+            }
+
+            void define(uint32_t a_id, spv::Op a_opcode, const uint32_t* a_operands, uint32_t a_count)
+            {
+                id_info& info = m_ids[a_id];
+                info.opcode = a_opcode;
+                info.operands.assign(a_operands, a_operands + a_count);
+            }
+
+            void decorate(id_info& a_info, spv::Decoration a_decoration, uint32_t a_value)
+            {
+                switch (a_decoration)
+                {
+                case spv::DecorationDescriptorSet: a_info.set = a_value;          break;
+                case spv::DecorationBinding:       a_info.binding = a_value;      break;
+                case spv::DecorationLocation:      a_info.location = a_value;     break;
+                case spv::DecorationArrayStride:   a_info.array_stride = a_value; break;
+                case spv::DecorationSpecId:        a_info.spec_id = a_value;      break;
+                case spv::DecorationBlock:         a_info.block = true;           break;
+                case spv::DecorationBufferBlock:   a_info.buffer_block = true;    break;
+                case spv::DecorationBuiltIn:       a_info.builtin = true;         break;
+                default:                                                          break;
+                }
+            }
+
+        private:
+            std::unordered_map<uint32_t, id_info> m_ids;
+        };
+
+        vk::Format input_format(const spirv_parser& a_parser, uint32_t a_type)
+        {
+            const id_info* type = a_parser.find(a_type);
+            if (!type)
+                return vk::Format::eUndefined;
+
+            uint32_t components = 1;
+            if (type->opcode == spv::OpTypeVector)
+            {
+                components = type->operands[1];
+                type = a_parser.find(type->operands[0]);
+            }
+
+            // 32-bit scalars and vectors cover every attribute the renderer feeds
+            if (!type || type->operands.empty() || type->operands[0] != 32)
+                return vk::Format::eUndefined;
+
+            static const vk::Format float_formats[] = { vk::Format::eR32Sfloat, vk::Format::eR32G32Sfloat, 
+                                                        vk::Format::eR32G32B32Sfloat, vk::Format::eR32G32B32A32Sfloat };
+            static const vk::Format sint_formats[]  = { vk::Format::eR32Sint, vk::Format::eR32G32Sint, 
+                                                        vk::Format::eR32G32B32Sint, vk::Format::eR32G32B32A32Sint };
+            static const vk::Format uint_formats[]  = { vk::Format::eR32Uint, vk::Format::eR32G32Uint, 
+                                                        vk::Format::eR32G32B32Uint, vk::Format::eR32G32B32A32Uint };
+
+            if (components < 1 || components > 4)
+                return vk::Format::eUndefined;
+
+            if (type->opcode == spv::OpTypeFloat)
+                return float_formats[components - 1];
+
+            if (type->opcode == spv::OpTypeInt)
+                return type->operands[1] ? sint_formats[components - 1] : uint_formats[components - 1];
+
+            return vk::Format::eUndefined;
+        }
+
+        // Returns false for resources that aren't descriptors (e.g. plain arrays of data)
+        bool descriptor_type(const spirv_parser& a_parser, 
+                             uint32_t a_type, 
+                             spv::StorageClass a_storage, 
+                             reflected_binding& a_binding)
+        {
+            a_binding.count = 1;
+
+            // arrays of descriptors, runtime-sized ones count as one here
+            const id_info* type = a_parser.find(a_type);
+            while (type && (type->opcode == spv::OpTypeArray || type->opcode == spv::OpTypeRuntimeArray))
+            {
+                if (type->opcode == spv::OpTypeArray)
+                    a_binding.count *= a_parser.constant_value(type->operands[1]);
+
+                a_type = type->operands[0];
+                type = a_parser.find(a_type);
+            }
+
+            if (!type)
+                return false;
+
+            a_binding.size = 0;
+
+            switch (type->opcode)
+            {
+            case spv::OpTypeStruct:
+                a_binding.size = a_parser.size_of(a_type);
+
+                if (a_storage == spv::StorageClassStorageBuffer || type->buffer_block)
+                    a_binding.type = vk::DescriptorType::eStorageBuffer;
+                else if (type->block)
+                    a_binding.type = vk::DescriptorType::eUniformBuffer;
+                else
+                    return false;
+                return true;
+
+            case spv::OpTypeSampledImage:
+                a_binding.type = vk::DescriptorType::eCombinedImageSampler;
+                return true;
+
+            case spv::OpTypeSampler:
+                a_binding.type = vk::DescriptorType::eSampler;
+                return true;
+
+            case spv::OpTypeImage:
+            {
+                // operands: sampled type, dim, depth, arrayed, ms, sampled, format
+                const spv::Dim dim = static_cast<spv::Dim>(type->operands[1]);
+                const bool storage = type->operands[5] == 2;
+
+                if (dim == spv::DimSubpassData)
+                    a_binding.type = vk::DescriptorType::eInputAttachment;
+                else if (dim == spv::DimBuffer)
+                    a_binding.type = storage ? vk::DescriptorType::eStorageTexelBuffer : vk::DescriptorType::eUniformTexelBuffer;
+                else
+                    a_binding.type = storage ? vk::DescriptorType::eStorageImage : vk::DescriptorType::eSampledImage;
+                return true;
+            }
+
+            default:
+                return false;
+            }
+        }
+    }
+
+    bool reflect_spirv(const uint32_t* a_words, 
+                       size_t a_size, 
+                       vk::ShaderStageFlagBits a_stage, 
+                       shader_reflection& a_reflection)
+    {
+        spirv_parser parser;
+
+        if (!parser.parse(a_words, a_size / sizeof(uint32_t)))
+            return false;
+
+        a_reflection = shader_reflection();
+        a_reflection.stage = a_stage;
+
+        for (const auto& i_entry : parser.ids())
+        {
+            const id_info& variable = i_entry.second;
+
+            // only scalar spec constants carry a SpecId, composites are built from them
+            if (variable.spec_id != UNSET)
+                a_reflection.specialization_ids.push_back(variable.spec_id);
+
+            if (variable.opcode != spv::OpVariable || variable.operands.size() < 2)
+                continue;
+
+            const spv::StorageClass storage = static_cast<spv::StorageClass>(variable.operands[1]);
+
+            // variables are always pointers, look through to the pointee
+            const id_info* pointer = parser.find(variable.operands[0]);
+            if (!pointer || pointer->opcode != spv::OpTypePointer)
+                continue;
+
+            const uint32_t type_id = pointer->operands[1];
+
+            switch (storage)
+            {
+            case spv::StorageClassUniform:
+            case spv::StorageClassUniformConstant:
+            case spv::StorageClassStorageBuffer:
+            {
+                reflected_binding binding;
+                binding.set = variable.set == UNSET ? 0 : variable.set;
+                binding.binding = variable.binding == UNSET ? 0 : variable.binding;
+
+                if (descriptor_type(parser, type_id, storage, binding))
+                    a_reflection.bindings.push_back(binding);
+                break;
+            }
+
+            case spv::StorageClassPushConstant:
+            {
+                const id_info* block = parser.find(type_id);
+                const uint32_t offset = block && !block->member_offsets.empty() 
+                                      ? *std::min_element(block->member_offsets.begin(), block->member_offsets.end()) 
+                                      : 0;
+
+                a_reflection.push_constants.emplace_back(a_stage, offset, parser.size_of(type_id) - offset);
+                break;
+            }
+
+            case spv::StorageClassInput:
+            {
+                const id_info* type = parser.find(type_id);
+
+                // gl_VertexIndex and friends come from the pipeline, not a vertex buffer
+                if (a_stage != vk::ShaderStageFlagBits::eVertex || variable.builtin || (type && type->builtin))
+                    break;
+
+                reflected_input input;
+                input.location = variable.location;
+                input.format = input_format(parser, type_id);
+                input.size = parser.size_of(type_id);
+
+                if (input.format == vk::Format::eUndefined)
+                {
+                    log->error("Vertex input at location {} has a type reflection does not support.", input.location);
+                    return false;
+                }
+
+                a_reflection.inputs.push_back(input);
+                break;
+            }
+
+            default:
+                break;
+            }
+        }
+
+        std::sort(a_reflection.bindings.begin(), a_reflection.bindings.end(), 
+                  [](const reflected_binding& a_lhs, const reflected_binding& a_rhs)
+        {
+            return a_lhs.set != a_rhs.set ? a_lhs.set < a_rhs.set : a_lhs.binding < a_rhs.binding;
+        });
+
+        std::sort(a_reflection.specialization_ids.begin(), a_reflection.specialization_ids.end());
+
+        std::sort(a_reflection.inputs.begin(), a_reflection.inputs.end(), 
+                  [](const reflected_input& a_lhs, const reflected_input& a_rhs)
+        {
+            return a_lhs.location < a_rhs.location;
+        });
+
+        return true;
+    }
+}
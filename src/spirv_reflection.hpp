@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace ppr
+{
+    struct reflected_binding
+    {
+        uint32_t set;
+        uint32_t binding;
+        vk::DescriptorType type;
+        uint32_t count;  // array size, 1 for a single descriptor
+        uint32_t size;   // bytes of the block for buffers, 0 otherwise
+    };
+
+    struct reflected_input
+    {
+        uint32_t location;
+        vk::Format format;
+        uint32_t size;
+    };
+
+    // What a shader module expects from the pipeline layout and vertex input,
+    // read from the SPIR-V binary. Uniform blocks are reported as plain uniform
+    // buffers, deciding whether they are bound dynamically is up to the caller.
+    struct shader_reflection
+    {
+        vk::ShaderStageFlagBits stage;
+        std::vector<reflected_binding> bindings;
+        std::vector<vk::PushConstantRange> push_constants;
+        std::vector<reflected_input> inputs; // vertex shaders only, sorted by location
+        std::vector<uint32_t> specialization_ids; // sorted
+    };
+
+    // Returns false for binaries it can't make sense of (bad header, unsupported input types)
+    bool reflect_spirv(const uint32_t* a_words, 
+                       size_t a_size, 
+                       vk::ShaderStageFlagBits a_stage, 
+                       shader_reflection& a_reflection);
+}
@@ -0,0 +1,165 @@
+#include "staging_ring.hpp"
+#include "logger.hpp"
+
+#include <cstring>
+
+namespace ppr
+{
+    constexpr vk::DeviceSize staging_ring::DEFAULT_CAPACITY;
+    constexpr vk::DeviceSize staging_ring::DEFAULT_ALIGNMENT;
+
+    staging_ring::staging_ring(const vk::Device& a_device, memory_allocator& an_allocator, timeline& a_timeline)
+        : m_timeline(a_timeline)
+        , m_buffer(a_device, an_allocator)
+        , m_mapped(nullptr)
+        , m_capacity(0)
+        , m_head(0)
+        , m_tail(0)
+        , m_used(0)
+        , m_pending(0)
+    {}
+
+    void staging_ring::create(vk::DeviceSize a_capacity)
+    {
+        log->trace("Creating staging ring...");
+
+        m_buffer.create(buffer::create_info(vk::MemoryPropertyFlagBits::eHostVisible
+                                          | vk::MemoryPropertyFlagBits::eHostCoherent,
+                                            vk::BufferUsageFlagBits::eTransferSrc,
+                                            a_capacity));
+
+        m_mapped = static_cast<char*>(m_buffer.mapped());
+        m_capacity = a_capacity;
+        m_head = m_tail = m_used = m_pending = 0;
+
+        log->trace("Created {} KiB staging ring.", a_capacity / 1024);
+    }
+
+    void staging_ring::destroy()
+    {
+        if (m_pending > 0)
+            log->warn("Destroying staging ring with {} bytes never submitted.", m_pending);
+
+        m_in_flight.clear();
+        m_buffer.destroy();
+        m_mapped = nullptr;
+        m_capacity = 0;
+    }
+
+    staging_region staging_ring::allocate(vk::DeviceSize a_size, vk::DeviceSize an_alignment)
+    {
+        if (a_size > m_capacity)
+        {
+            log->critical("Upload of {} bytes does not fit in the {} byte staging ring.", a_size, m_capacity);
+            return staging_region();
+        }
+
+        vk::DeviceSize offset = 0;
+
+        reclaim();
+        while (!try_allocate(a_size, an_alignment, offset))
+        {
+            if (m_in_flight.empty())
+            {
+                log->critical("Staging ring exhausted by {} bytes of unsubmitted uploads.", m_pending);
+                return staging_region();
+            }
+
+            // oldest submission has to finish before its bytes can be reused
+            m_timeline.wait(m_in_flight.front().value);
+            reclaim();
+        }
+
+        staging_region region;
+        region.offset = offset;
+        region.size = a_size;
+        region.data = m_mapped + offset;
+
+        return region;
+    }
+
+    staging_region staging_ring::write(const void* a_data, vk::DeviceSize a_size, vk::DeviceSize an_alignment)
+    {
+        const staging_region region = allocate(a_size, an_alignment);
+
+        if (region)
+            memcpy(region.data, a_data, static_cast<size_t>(a_size));
+
+        return region;
+    }
+
+    void staging_ring::submitted(uint64_t a_timeline_value)
+    {
+        if (m_pending == 0)
+            return;
+
+        m_in_flight.push_back({ a_timeline_value, m_head, m_pending });
+        m_pending = 0;
+    }
+
+    const buffer& staging_ring::source() const
+    {
+        return m_buffer;
+    }
+
+    vk::DeviceSize staging_ring::capacity() const
+    {
+        return m_capacity;
+    }
+
+    vk::DeviceSize staging_ring::pending_size() const
+    {
+        return m_pending;
+    }
+
+    void staging_ring::reclaim()
+    {
+        const uint64_t completed = m_timeline.completed_value();
+
+        while (!m_in_flight.empty() && m_in_flight.front().value <= completed)
+        {
+            m_tail = m_in_flight.front().end;
+            m_used -= m_in_flight.front().size;
+            m_in_flight.pop_front();
+        }
+
+        // fully drained, start over at the front to avoid needless wrapping
+        if (m_used == 0)
+            m_head = m_tail = 0;
+    }
+
+    bool staging_ring::try_allocate(vk::DeviceSize a_size, vk::DeviceSize an_alignment, vk::DeviceSize& an_offset)
+    {
+        const vk::DeviceSize aligned = (m_head + an_alignment - 1) / an_alignment * an_alignment;
+
+        // head == tail is ambiguous; the used count tells empty from full
+        const bool contiguous = m_head > m_tail || m_used == 0;
+
+        vk::DeviceSize taken = 0;
+
+        if (contiguous && aligned + a_size <= m_capacity)
+        {
+            an_offset = aligned;
+            taken = aligned - m_head + a_size;
+        }
+        else if (contiguous && a_size <= m_tail)
+        {
+            // wrap around, the tail end of the buffer is wasted until reclaimed
+            an_offset = 0;
+            taken = m_capacity - m_head + a_size;
+        }
+        else if (!contiguous && aligned + a_size <= m_tail)
+        {
+            an_offset = aligned;
+            taken = aligned - m_head + a_size;
+        }
+        else
+            return false;
+
+        m_head = an_offset + a_size;
+        m_used += taken;
+        m_pending += taken;
+
+        return true;
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "timeline.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <deque>
+
+namespace ppr
+{
+    // A slice of the staging ring that the caller fills and copies from
+    struct staging_region
+    {
+        vk::DeviceSize offset = 0;
+        vk::DeviceSize size = 0;
+        void* data = nullptr;
+
+        explicit operator bool() const
+        { return data != nullptr; }
+    };
+
+    // One persistently mapped host-visible buffer that every upload is staged
+    // through. Writes are appended at the head; once the copies reading them are
+    // submitted the bytes are tagged with that timeline value and handed back as
+    // soon as the timeline passes it. Staging an upload creates no Vulkan objects
+    // and maps nothing.
+    class staging_ring
+    {
+    public:
+        staging_ring(const vk::Device& a_device, memory_allocator& an_allocator, timeline& a_timeline);
+
+        void create(vk::DeviceSize a_capacity = DEFAULT_CAPACITY);
+        void destroy();
+
+        // Reserve a_size bytes, waiting on older submissions if the ring is full. The
+        // region is empty when a_size exceeds the ring or unsubmitted bytes fill it.
+        staging_region allocate(vk::DeviceSize a_size, vk::DeviceSize an_alignment = DEFAULT_ALIGNMENT);
+        // Reserve and fill in one step
+        staging_region write(const void* a_data, vk::DeviceSize a_size, vk::DeviceSize an_alignment = DEFAULT_ALIGNMENT);
+
+        // Everything reserved since the previous call is read by the submission with this value
+        void submitted(uint64_t a_timeline_value);
+
+        const buffer& source() const;
+        vk::DeviceSize capacity() const;
+        vk::DeviceSize pending_size() const;
+
+    public:
+        static constexpr vk::DeviceSize DEFAULT_CAPACITY = 32ull * 1024 * 1024;
+        static constexpr vk::DeviceSize DEFAULT_ALIGNMENT = 16;
+
+    private:
+        void reclaim();
+        bool try_allocate(vk::DeviceSize a_size, vk::DeviceSize an_alignment, vk::DeviceSize& an_offset);
+
+    private:
+        timeline& m_timeline;
+
+        buffer m_buffer;
+        char* m_mapped;
+        vk::DeviceSize m_capacity;
+
+        vk::DeviceSize m_head; // next byte to hand out
+        vk::DeviceSize m_tail; // oldest byte still in use
+        vk::DeviceSize m_used; // bytes between tail and head, wrap padding included
+        vk::DeviceSize m_pending; // bytes not yet tagged with a timeline value
+
+        struct in_flight
+        {
+            uint64_t value;
+            vk::DeviceSize end;
+            vk::DeviceSize size;
+        };
+
+        std::deque<in_flight> m_in_flight;
+    };
+}
@@ -2,7 +2,7 @@
 
 #pragma once
 
-using uint32_t = unsigned int;
+#include "globals.hpp"
 
 namespace ppr
 {
@@ -22,6 +22,29 @@ namespace ppr
 	};
 }
 
+namespace ppr
+{
+	struct context_config
+	{
+	public:
+		uint32_t frames_in_flight = DEFAULT_FRAMES_IN_FLIGHT;
+
+		// Render into offscreen images without a window, surface or presentation
+		bool headless = false;
+
+		size<uint32_t> extent = { 800, 600 };
+
+		// Rebuild pipelines in the background when shader sources change on disk
+		bool hot_reload = SHADER_HOT_RELOAD_DEFAULT;
+
+		// Threads recording draws each frame, the render thread included, and threads
+		// creating pipelines in the background. Both can be busy at once, so whichever
+		// is 0 gets the cores the other leaves, and both at 0 split them.
+		uint32_t record_threads = 0;
+		uint32_t compile_threads = 0;
+	};
+}
+
 namespace ppr
 {
 	struct queue_families
@@ -29,6 +52,7 @@ namespace ppr
 	public:
 		int graphics = UNAVAILABLE;
 		int present = UNAVAILABLE;
+		int transfer = UNAVAILABLE; // same as graphics when there is no transfer-only family
 
 		static constexpr int UNAVAILABLE = -1;
 		static constexpr int MIN_INDEX = 0;
@@ -36,5 +60,8 @@ namespace ppr
 	public:
 		bool is_complete() const
 		{ return graphics >= MIN_INDEX && present >= MIN_INDEX; }
+
+		bool has_dedicated_transfer() const
+		{ return transfer >= MIN_INDEX && transfer != graphics; }
 	};
 }
\ No newline at end of file
@@ -3,20 +3,57 @@
 #include "callbacks.hpp"
 #include "logger.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <set>
+
 namespace ppr
 {
 	swapchain::swapchain(const vk::Device& a_device, 
                          const window& a_window,
                          const vk::Instance& an_instance, 
-                         const vk::PhysicalDevice& a_physical_device)
-		: m_device(a_device)
-		, m_pipeline(a_device, m_extent2D)
-		, m_vertex_buffer(a_device)
-        , m_index_buffer(a_device)
+                         const vk::PhysicalDevice& a_physical_device,
+                         memory_allocator& an_allocator,
+                         const pipeline_cache& a_pipeline_cache,
+                         shader_module_cache& a_shader_modules,
+                         pipeline_compiler& a_pipeline_compiler,
+                         pipeline_layout_cache& a_layouts,
+                         const context_config& a_config)
+		: m_config(a_config)
+		, m_device(a_device)
+		, m_vertex_buffer(a_device, an_allocator)
+        , m_index_buffer(a_device, an_allocator)
 		, m_window(a_window)
 		, m_instance(an_instance)
 		, m_physical_device(a_physical_device)
-	{}
+		, m_allocator(an_allocator)
+		, m_pipeline_cache(a_pipeline_cache)
+		, m_shader_modules(a_shader_modules)
+		, m_pipeline_compiler(a_pipeline_compiler)
+		, m_layouts(a_layouts)
+		, m_pipelines(a_device, a_pipeline_cache, a_shader_modules, a_layouts, a_pipeline_compiler)
+		, m_default_pipeline(0)
+		, m_pipeline_generation(0)
+		, m_reloaded_generation(0)
+		, m_reload_ready(false)
+		, m_shader_watcher({ std::string(SHADER_DIR) + "shader.vert", std::string(SHADER_DIR) + "shader.frag" })
+		, m_timeline(a_device, m_queue_graphics)
+		, m_transfer_timeline(a_device, m_queue_transfer)
+		, m_staging(a_device, an_allocator, m_transfer_timeline)
+		, m_uploads(a_device, m_transfer_timeline, m_timeline, m_staging)
+		, m_uniforms(a_device, a_physical_device, an_allocator)
+		, m_commands(a_device)
+		, m_recorder(m_commands, a_config.record_threads)
+		, m_frames_in_flight(a_config.frames_in_flight)
+		, m_frame_index(0)
+		, m_frame_number(0)
+		, m_frames(a_config.frames_in_flight)
+		, m_deletions(a_device, { &m_timeline, &m_transfer_timeline })
+		, m_profiler(a_device, a_physical_device)
+	{
+		if (m_frames_in_flight == 0)
+			log->critical("At least one frame in flight is required.");
+	}
 
 	swapchain::~swapchain()
 	{
@@ -29,22 +66,101 @@ namespace ppr
 		wndcall.add(&swapchain::on_window_resize, this, call_type::RESIZE);
 		create();
 		create_imageviews();
+		create_uniforms();
 		create_renderpass();
-		m_pipeline.create();
+		create_pipelines();
+		prewarm_pipelines();
 		create_framebuffers();
-		create_commandpool();
-		m_vertex_buffer.create(m_physical_device, 
-                               m_commandpool, 
-                               m_queue_graphics);
-        m_index_buffer.create(m_physical_device, 
-                               m_commandpool, 
-                               m_queue_graphics);
-		create_commandbuffers();
-		create_semaphores();
+		create_commandpools();
+		m_staging.create();
+		const queue_families family_indices = find_queue_families(m_physical_device);
+		m_uploads.init(family_indices.transfer, family_indices.graphics);
+		m_vertex_buffer.create(m_uploads);
+        m_index_buffer.create(m_uploads);
+		m_draws = { draw_call{ static_cast<uint32_t>(m_index_buffer.indices().size()), 0, 0, m_default_pipeline } };
+		m_draw_pipelines = { m_default_pipeline };
+		create_sync_objects();
+		m_profiler.init(m_frames_in_flight, find_queue_families(m_physical_device).graphics);
+
+		if (m_config.hot_reload)
+			m_shader_watcher.start([this]() { rebuild_pipelines(); });
 
 		m_initialized = true;
 	}
 
+	bool swapchain::load_scene(const scene& a_scene)
+	{
+		log->debug("Loading scene: {} vertices, {} indices, {} draws, {} pipelines.", 
+                   a_scene.vertices.size(), a_scene.indices.size(), 
+                   a_scene.draws.size(), a_scene.pipelines.size());
+
+		// Checked before anything is replaced, a rejected scene leaves the current one drawing
+		for (const auto& i_draw : a_scene.draws)
+		{
+			if (!a_scene.pipelines.empty() && i_draw.pipeline_index >= a_scene.pipelines.size())
+			{
+				log->error("Rejected scene, a draw uses pipeline {} of {}.", i_draw.pipeline_index, a_scene.pipelines.size());
+				return false;
+			}
+		}
+
+		// Copies still queued may target the old buffers, submit them so the deletions below outlive them
+		m_uploads.flush();
+
+		m_vertex_buffer.destroy(m_deletions);
+        m_index_buffer.destroy(m_deletions);
+
+		m_vertex_buffer.set_vertices(a_scene.vertices);
+        m_index_buffer.set_indices(a_scene.indices);
+
+		m_vertex_buffer.create(m_uploads);
+        m_index_buffer.create(m_uploads);
+
+		// Pipelines outlive scenes, only descriptions not seen before are compiled
+		std::vector<uint32_t> pipeline_ids;
+		{
+			// Waits for a reload in progress, the registry can't grow while it reads
+			std::lock_guard<std::mutex> lock(m_reload_mutex);
+
+			const uint32_t known = m_pipelines.size();
+
+			for (const auto& i_description : a_scene.pipelines)
+				pipeline_ids.push_back(m_pipelines.request(for_render_pass(i_description)));
+
+			log->debug("Scene uses {} distinct pipelines, {} new.", 
+                       std::set<uint32_t>(pipeline_ids.begin(), pipeline_ids.end()).size(), 
+                       m_pipelines.size() - known);
+		}
+
+		// Releases modules no pipeline holds anymore
+		m_shader_modules.trim();
+
+		m_draws = a_scene.draws;
+
+		std::set<uint32_t> draw_pipelines;
+
+		for (auto& i_draw : m_draws)
+		{
+			i_draw.pipeline_index = pipeline_ids.empty() ? m_default_pipeline : pipeline_ids[i_draw.pipeline_index];
+			draw_pipelines.insert(i_draw.pipeline_index);
+		}
+
+		m_draw_pipelines.assign(draw_pipelines.begin(), draw_pipelines.end());
+
+		// Every draw gets its own uniform slot each frame, after the frame's own
+		m_uniforms.reserve(m_uniforms.stride(sizeof(frame_uniforms)) 
+                         + m_uniforms.stride(sizeof(draw_uniforms)) * m_draws.size(), m_deletions);
+
+		// Groups draws sharing a pipeline so each is bound once. Stable, so draws with the
+		// same pipeline keep their order; order between pipelines is not preserved.
+		std::stable_sort(m_draws.begin(), m_draws.end(), [](const draw_call& a_lhs, const draw_call& a_rhs)
+		{
+			return a_lhs.pipeline_index < a_rhs.pipeline_index;
+		});
+
+		return true;
+	}
+
 	void swapchain::on_window_resize()
 	{
 		this->recreate();
@@ -53,36 +169,227 @@ namespace ppr
 
 	void swapchain::draw()
 	{
-        const vk::ResultValue<uint32_t> result_pair = m_device.acquireNextImageKHR(m_swapchain, 
-                                                                                   UINT64_MAX, 
-                                                                                   m_sema_image_available, 
-                                                                                   nullptr);
-        const uint32_t image_index = result_pair.value;
+		frame_context frame;
 
-		if (print(result_pair.result) == vk::Result::eErrorOutOfDateKHR)
-		{
-			this->recreate();
+		if (!begin_frame(frame))
 			return;
+
+		record_commands(frame);
+		end_frame(frame);
+	}
+
+	bool swapchain::begin_frame(frame_context& a_frame)
+	{
+		frame_resources& resources = m_frames[m_frame_index];
+
+		m_deletions.collect();
+
+		if (m_reload_ready)
+			swap_reloaded_pipelines();
+
+		// Only blocks if the GPU is still working on the frame that last used this slot
+		m_timeline.wait(resources.submit_value);
+
+		uint32_t image_index = 0;
+
+		if (m_config.headless)
+			image_index = static_cast<uint32_t>(m_frame_number % m_images.size());
+		else
+		{
+            const vk::ResultValue<uint32_t> result_pair = m_device.acquireNextImageKHR(m_swapchain, 
+                                                                                       UINT64_MAX, 
+                                                                                       resources.image_available, 
+                                                                                       nullptr);
+            image_index = result_pair.value;
+
+			if (print(result_pair.result) == vk::Result::eErrorOutOfDateKHR)
+			{
+				this->recreate();
+				return false;
+			}
+			else if (result_pair.result != vk::Result::eSuccess 
+                                        && result_pair.result != vk::Result::eSuboptimalKHR)
+				log->critical("Failed to acquire swapchain image.");
+		}
+
+		// The image may still be in use by an older frame if images are acquired out of order
+		m_timeline.wait(m_images_in_flight[image_index]);
+
+		resources.frame_number = m_frame_number;
+		m_commands.begin_frame(m_frame_index);
+		m_uniforms.begin_frame(m_frame_index);
+
+		a_frame.index           = m_frame_index;
+		a_frame.image_index     = image_index;
+		a_frame.number          = m_frame_number;
+		a_frame.commandbuffer   = m_commands.allocate(0, vk::CommandBufferLevel::ePrimary);
+		a_frame.framebuffer     = m_framebuffers[image_index];
+		a_frame.extent          = m_extent2D;
+		a_frame.image_available = resources.image_available;
+		a_frame.render_finished = resources.render_finished;
+
+		return true;
+	}
+
+	void swapchain::record_commands(const frame_context& a_frame)
+	{
+		const vk::CommandBuffer& cmd = a_frame.commandbuffer;
+
+        const vk::CommandBufferBeginInfo cmdbuffer_begin_info(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+		cmd.begin(cmdbuffer_begin_info);
+
+		m_profiler.begin_frame(a_frame);
+		record_scene(a_frame);
+		cmd.end();
+	}
+
+	void swapchain::record_scene(const frame_context& a_frame)
+	{
+		const vk::CommandBuffer& cmd = a_frame.commandbuffer;
+		const profiler::scope frame_scope(m_profiler, cmd, "frame");
+
+        const vk::ClearValue clear_color(vk::ClearColorValue(std::array<float, 4>({ 0.f, 0.f, 0.f, 1.f })));
+        const vk::Rect2D draw_rect({ 0, 0 }, a_frame.extent);
+        const vk::RenderPassBeginInfo renderpass_info(m_renderpass, 
+                                                      a_frame.framebuffer, 
+                                                      draw_rect, 1, 
+                                                     &clear_color);
+
+		// The registry isn't safe to write from the recording threads
+		for (const uint32_t i_id : m_draw_pipelines)
+			m_pipelines.mark_used(i_id);
+
+		frame_uniforms frame_data;
+		frame_data.view_projection = glm::mat4(1.f);
+		const uniform_allocation frame_uniform = m_uniforms.push(frame_data);
+
+		// One block for every draw, so threads fill their own slots without allocating
+		const uniform_allocation draw_uniforms_block = m_uniforms.allocate(m_uniforms.stride(sizeof(draw_uniforms)) * m_draws.size());
+
+		// load_scene() sizes the slices for every draw, without room the pass only clears
+		const size_t draw_count = frame_uniform && draw_uniforms_block ? m_draws.size() : 0;
+
+		const profiler::scope pass_scope(m_profiler, cmd, "main pass");
+
+		if (m_recorder.chunk_count(draw_count) <= 1)
+		{
+			cmd.beginRenderPass(renderpass_info, vk::SubpassContents::eInline);
+
+			const profiler::scope draw_scope(m_profiler, cmd, "draws");
+			record_draws(cmd, a_frame, frame_uniform, draw_uniforms_block, 0, draw_count);
 		}
-		else if (result_pair.result != vk::Result::eSuccess 
-                                    && result_pair.result != vk::Result::eSuboptimalKHR)
-			log->critical("Failed to acquire swapchain image.");
+		else
+		{
+			// Only vkCmdExecuteCommands may follow, so the draws can't have a scope of their own
+			cmd.beginRenderPass(renderpass_info, vk::SubpassContents::eSecondaryCommandBuffers);
+
+			const vk::CommandBufferInheritanceInfo inheritance(m_renderpass, 0, a_frame.framebuffer);
+
+			const std::vector<vk::CommandBuffer>& secondaries = m_recorder.record(draw_count, inheritance, 
+				[&](const vk::CommandBuffer& a_commandbuffer, size_t a_begin, size_t a_end)
+			{
+				record_draws(a_commandbuffer, a_frame, frame_uniform, draw_uniforms_block, a_begin, a_end);
+			});
+
+			cmd.executeCommands(secondaries);
+		}
+
+		cmd.endRenderPass();
+	}
+
+	void swapchain::record_draws(const vk::CommandBuffer& a_commandbuffer, const frame_context& a_frame, 
+                                 const uniform_allocation& a_frame_uniform, const uniform_allocation& a_draw_uniforms, 
+                                 size_t a_begin, size_t a_end) const
+	{
+		const vk::CommandBuffer& cmd = a_commandbuffer;
+
+		// Secondaries inherit none of this, every range sets it again
+        const vk::Viewport viewport(0.f, 0.f, 
+                                    static_cast<float>(a_frame.extent.width), 
+                                    static_cast<float>(a_frame.extent.height), 
+                                    0.f, 1.f);
+		cmd.setViewport(0, viewport);
+		cmd.setScissor(0, vk::Rect2D({ 0, 0 }, a_frame.extent));
+
+        const vk::Buffer     vertex_buffers[] = { m_vertex_buffer.get() };
+        const vk::DeviceSize buffer_offsets[] = { 0 };
+		cmd.bindVertexBuffers(0, 1, vertex_buffers, buffer_offsets);
+        cmd.bindIndexBuffer(m_index_buffer.get(), 0, vk::IndexType::eUint32);
+
+		const vk::DeviceSize draw_stride = m_uniforms.stride(sizeof(draw_uniforms));
+
+		// Draws whose pipeline is still compiling use the first one instead of stalling
+		const pipeline& fallback = m_pipelines.get(m_default_pipeline)->get();
+		const pipeline* bound_pipeline = nullptr;
+		uint32_t bound_index = UINT32_MAX;
+
+		for (size_t i = a_begin; i < a_end; ++i)
+		{
+			const draw_call& draw = m_draws[i];
+
+			if (draw.pipeline_index != bound_index)
+			{
+				bound_index = draw.pipeline_index;
 
-		const vk::Semaphore sema_wait[] = { m_sema_image_available };
-		const vk::Semaphore sema_signal[] = { m_sema_render_finished };
+				const pipeline_handle& handle = m_pipelines.get(bound_index);
+				const pipeline* next = handle->is_ready() ? &handle->get() : &fallback;
+
+				if (next != bound_pipeline)
+				{
+					bound_pipeline = next;
+					cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, bound_pipeline->get());
+				}
+			}
+
+			const vk::DeviceSize draw_offset = draw_stride * i;
+
+			draw_uniforms draw_data;
+			draw_data.model = draw.transform;
+			memcpy(static_cast<char*>(a_draw_uniforms.data) + draw_offset, &draw_data, sizeof(draw_data));
+
+			// pipelines share one layout, so any of them can bind the set
+			const std::array<uint32_t, 2> dynamic_offsets = {{ a_frame_uniform.dynamic_offset, 
+                                                               a_draw_uniforms.dynamic_offset + static_cast<uint32_t>(draw_offset) }};
+			cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, bound_pipeline->get_layout(), 
+                                   0, m_uniforms.descriptor_set(), dynamic_offsets);
+
+			cmd.drawIndexed(draw.index_count, 1, draw.first_index, draw.vertex_offset, 0);
+		}
+	}
+
+	void swapchain::end_frame(const frame_context& a_frame)
+	{
+		const vk::Semaphore sema_wait[] = { a_frame.image_available };
+		const vk::Semaphore sema_signal[] = { a_frame.render_finished };
         const vk::PipelineStageFlags wait_stages[] = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
 
-        const vk::SubmitInfo submit_info(1, sema_wait, 
+        // Offscreen images are never acquired or presented, so there is nothing to wait on or signal
+        const uint32_t sema_count = m_config.headless ? 0 : 1;
+
+        const vk::SubmitInfo submit_info(sema_count, sema_wait, 
                                          wait_stages, 1, 
-                                        &m_commandbuffers[image_index], 1, 
+                                        &a_frame.commandbuffer, sema_count, 
                                          sema_signal);
 
-		m_queue_graphics.submit(submit_info, nullptr);
+		// Uploads queued since the last frame go first, their barrier covers this frame's reads
+		m_uploads.flush();
+
+		const uint64_t submit_value = m_timeline.submit(submit_info);
+
+		m_frames[a_frame.index].submit_value = submit_value;
+		m_images_in_flight[a_frame.image_index] = submit_value;
+
+		// Advance before presenting so a recreate below starts cleanly on the next slot
+		m_frame_index = (m_frame_index + 1) % m_frames_in_flight;
+		++m_frame_number;
+
+		if (m_config.headless)
+			return;
 
         const vk::SwapchainKHR swapchains[] = { m_swapchain };
         const vk::PresentInfoKHR present_info(1, sema_signal, 
                                               1, swapchains, 
-                                             &image_index);
+                                             &a_frame.image_index);
 
 		const auto result = m_queue_present.presentKHR(present_info);
 
@@ -94,12 +401,16 @@ namespace ppr
 		}
 		else if (result != vk::Result::eSuccess)
 			log->critical("Failed to present swapchain image.");
-
-		m_queue_present.waitIdle();
 	}
 
 	void swapchain::create()
 	{
+		if (m_config.headless)
+		{
+			create_offscreen_images();
+			return;
+		}
+
 		log->trace("Creating swapchain...");
 
 		const swapchain_support support_details = query_support(m_physical_device);
@@ -147,7 +458,8 @@ namespace ppr
 		swapchain_createinfo.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque;
 		swapchain_createinfo.presentMode = present_mode;
 		swapchain_createinfo.clipped = true;
-		swapchain_createinfo.oldSwapchain = nullptr;
+		// Lets the presentation engine keep showing the old images while we switch over
+		swapchain_createinfo.oldSwapchain = m_swapchain;
 
 
 		m_swapchain = m_device.createSwapchainKHR(swapchain_createinfo);
@@ -179,6 +491,34 @@ namespace ppr
 
 	}
 
+	void swapchain::create_offscreen_images()
+	{
+		log->trace("Creating offscreen images...");
+
+		m_image_format = vk::Format::eB8G8R8A8Unorm;
+		m_extent2D = vk::Extent2D(m_config.extent.width, m_config.extent.height);
+
+		// One image per frame in flight, so frames never wait on each other's target
+		m_images.resize(m_frames_in_flight);
+		m_image_memory.resize(m_frames_in_flight);
+
+		for (size_t i = 0; i < m_images.size(); ++i)
+		{
+            const vk::ImageCreateInfo image_createinfo({}, vk::ImageType::e2D, 
+                                                       m_image_format, 
+                                                       vk::Extent3D(m_extent2D, 1), 1, 1, 
+                                                       vk::SampleCountFlagBits::e1, 
+                                                       vk::ImageTiling::eOptimal, 
+                                                       vk::ImageUsageFlagBits::eColorAttachment 
+                                                     | vk::ImageUsageFlagBits::eTransferSrc);
+
+			m_images[i] = m_device.createImage(image_createinfo);
+			m_image_memory[i] = m_allocator.allocate_image(m_images[i], vk::MemoryPropertyFlagBits::eDeviceLocal);
+		}
+
+		log->trace("Created {} offscreen {}x{} images.", m_images.size(), m_extent2D.width, m_extent2D.height);
+	}
+
 	void swapchain::create_window_surface()
 	{
 		log->trace("Creating Vulkan surface...");
@@ -200,6 +540,17 @@ namespace ppr
              && queue_fam_properties[i].queueFlags & vk::QueueFlagBits::eGraphics)
 				family_indices.graphics = i;
 
+			// Nothing is presented headless, the graphics queue stands in for the present queue
+			if (m_config.headless)
+			{
+				family_indices.present = family_indices.graphics;
+
+				if (family_indices.is_complete())
+					break;
+
+				continue;
+			}
+
 			vk::Bool32 present_support = a_device.getSurfaceSupportKHR(i, m_surface);
 
 			if (queue_fam_properties[i].queueCount > queue_families::MIN_INDEX 
@@ -209,6 +560,24 @@ namespace ppr
 			if (family_indices.is_complete())
 				break;
 		}
+
+		// A transfer-only family usually maps to a DMA engine that copies alongside rendering
+		for (uint16_t i = 0; i < queue_fam_properties.size(); ++i)
+		{
+			const vk::QueueFlags flags = queue_fam_properties[i].queueFlags;
+
+			if (queue_fam_properties[i].queueCount > 0 
+             && flags & vk::QueueFlagBits::eTransfer 
+             && !(flags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute)))
+			{
+				family_indices.transfer = i;
+				break;
+			}
+		}
+
+		if (family_indices.transfer == queue_families::UNAVAILABLE)
+			family_indices.transfer = family_indices.graphics;
+
 		return family_indices;
 	}
 
@@ -291,34 +660,112 @@ namespace ppr
 		return m_queue_present;
 	}
 
+    vk::Queue& swapchain::transfer_queue()
+	{
+		return m_queue_transfer;
+	}
+
+	uint32_t swapchain::frames_in_flight() const
+	{
+		return m_frames_in_flight;
+	}
+
+	bool swapchain::frame_retired(uint64_t a_frame_number)
+	{
+		if (a_frame_number >= m_frame_number)
+			return false;
+
+		const frame_resources& resources = m_frames[a_frame_number % m_frames_in_flight];
+
+		// A slot is only reused once the frame that previously occupied it has been waited on
+		if (resources.frame_number != a_frame_number)
+			return true;
+
+		return m_timeline.has_retired(resources.submit_value);
+	}
+
+	timeline& swapchain::graphics_timeline()
+	{
+		return m_timeline;
+	}
+
+	const profiler_report& swapchain::frame_report() const
+	{
+		return m_profiler.frame_report();
+	}
+
 	void swapchain::cleanup()
 	{
+		m_deletions.flush();
+
 		for (auto i_buffer : m_framebuffers)
 			m_device.destroyFramebuffer(i_buffer);
 
-		m_device.freeCommandBuffers(m_commandpool, m_commandbuffers);
+		for (auto i_view : m_image_views)
+			m_device.destroyImageView(i_view);
 
-		m_pipeline.destroy();
+		if (m_config.headless)
+		{
+			for (auto i_image : m_images)
+				m_device.destroyImage(i_image);
 
-		m_vertex_buffer.destroy();
-        m_index_buffer.destroy();
+			for (const auto& i_memory : m_image_memory)
+				m_allocator.free(i_memory);
 
-		for (auto i_view : m_image_views)
-			m_device.destroyImageView(i_view);
+			m_images.clear();
+			m_image_memory.clear();
+		}
+		else
+			m_device.destroySwapchainKHR(m_swapchain);
 
-		m_device.destroySwapchainKHR(m_swapchain);
+		m_framebuffers.clear();
+		m_image_views.clear();
+		m_swapchain = nullptr;
 
 		m_destroyed = true;
 	}
 
 	void swapchain::destroy()
 	{
+		m_shader_watcher.stop();
+
 		if (!m_destroyed)
 			cleanup();
 
-		m_device.destroySemaphore(m_sema_render_finished);
-		m_device.destroySemaphore(m_sema_image_available);
-		m_device.destroyCommandPool(m_commandpool);
+		// cleanup() may have been called earlier, objects retired since then still need to go
+		m_deletions.flush();
+
+		// pipelines still compiling reference the render pass
+		m_pipeline_compiler.wait_idle();
+
+		// a session that never drew anything says nothing about what the next one needs
+		if (m_pipelines.used_count() > 0 && !m_pipelines.save_usage(PIPELINE_USAGE_PATH))
+			log->warn("Failed to save pipeline usage to \"{}\".", PIPELINE_USAGE_PATH);
+
+		m_pipelines.destroy();
+		pipeline_registry::discard(m_reloaded_pipelines);
+
+		m_device.destroyRenderPass(m_renderpass);
+
+		m_uniforms.destroy();
+		m_vertex_buffer.destroy();
+        m_index_buffer.destroy();
+
+		m_profiler.destroy();
+
+		for (const auto& i_frame : m_frames)
+		{
+			m_device.destroySemaphore(i_frame.render_finished);
+			m_device.destroySemaphore(i_frame.image_available);
+		}
+
+		m_uploads.destroy();
+		m_staging.destroy();
+		m_transfer_timeline.destroy();
+		m_timeline.destroy();
+
+		m_recorder.destroy();
+		m_commands.destroy();
 	}
 
 	void swapchain::create_framebuffers()
@@ -331,7 +778,7 @@ namespace ppr
 		{
             const vk::ImageView attachments[] = { m_image_views[i] };
 
-            const vk::FramebufferCreateInfo framebuffer_info({}, m_pipeline.get_renderpass(), 1, 
+            const vk::FramebufferCreateInfo framebuffer_info({}, m_renderpass, 1, 
                                                              attachments, 
                                                              m_extent2D.width, 
                                                              m_extent2D.height, 1);
@@ -344,89 +791,97 @@ namespace ppr
 
 	void swapchain::recreate()
 	{
+		// Offscreen images have a fixed size
+		if (m_config.headless)
+			return;
+
 		const auto window_size = m_window.get_size();
 
 		if (window_size.width == 0 || window_size.height == 0)
 			return;
 
-		m_device.waitIdle();
+		log->trace("Recreating swapchain...");
+
+		// Geometry, command pools and sync objects do not depend on the swapchain and are kept.
+		// Everything that does goes to the deletion queue instead of waiting for the device.
+		const vk::Format old_format = m_image_format;
+
+		// vkQueuePresentKHR signals nothing the deletion queue can wait on, so a present of an
+		// old image may still be pending once the frame that rendered it has retired
+		m_queue_present.waitIdle();
 
-		cleanup();
+		retire_swapchain_resources();
 
 		create();
 		create_imageviews();
-		create_renderpass();
-		m_pipeline.create();
+
+		// Pipelines use dynamic viewport/scissor, so only a format change (which makes the
+		// render pass incompatible) requires new pipelines
+		if (m_image_format != old_format)
+		{
+			std::lock_guard<std::mutex> lock(m_reload_mutex);
+
+			// Compiler workers may still be creating pipelines against the old render pass,
+			// prewarmed or reloaded ones included. The deletion queue only waits for the GPU.
+			m_pipeline_compiler.wait_idle();
+
+			m_deletions.destroy(m_renderpass);
+			create_renderpass();
+
+			// ids stay the same, so the draw list is untouched
+			m_pipelines.rebuild(m_renderpass, m_image_format, m_deletions);
+			++m_pipeline_generation;
+
+			wait_for_default_pipeline();
+		}
+
 		create_framebuffers();
-		m_vertex_buffer.create(m_physical_device, 
-                               m_commandpool, 
-                               m_queue_graphics);
-        m_index_buffer.create(m_physical_device, 
-                               m_commandpool, 
-                               m_queue_graphics);
-		create_commandbuffers();
+
+		m_images_in_flight.assign(m_images.size(), 0);
 
 		m_destroyed = false;
 	}
 
-	void swapchain::create_semaphores()
+	void swapchain::retire_swapchain_resources()
 	{
-        const vk::SemaphoreCreateInfo semaphore_createinfo = {};
+		// Nothing submitted after this point can reference the old objects
+		for (auto i_buffer : m_framebuffers)
+			m_deletions.destroy(i_buffer);
+
+		for (auto i_view : m_image_views)
+			m_deletions.destroy(i_view);
 
-		m_sema_image_available = m_device.createSemaphore(semaphore_createinfo);
-		m_sema_render_finished = m_device.createSemaphore(semaphore_createinfo);
+		m_deletions.destroy(m_swapchain);
 
-		// No error checking?
+		m_image_views.clear();
+		m_framebuffers.clear();
 	}
 
-	void swapchain::create_commandbuffers()
+	void swapchain::create_sync_objects()
 	{
-		log->trace("Creating Command Buffers...");
-
-		m_commandbuffers.resize(m_framebuffers.size());
+		log->trace("Creating frame synchronization objects...");
 
-        const vk::CommandBufferAllocateInfo cmdbuffer_alloc_info(m_commandpool, 
-                                                             vk::CommandBufferLevel::ePrimary, 
-                                                                 m_commandbuffers.size());
-
-		m_commandbuffers = m_device.allocateCommandBuffers(cmdbuffer_alloc_info);
+        const vk::SemaphoreCreateInfo semaphore_createinfo = {};
 
-		for (size_t i = 0; i < m_commandbuffers.size(); ++i)
+		for (auto& i_frame : m_frames)
 		{
-            const vk::CommandBufferBeginInfo cmdbuffer_begin_info(vk::CommandBufferUsageFlagBits::eSimultaneousUse);
-
-			m_commandbuffers[i].begin(cmdbuffer_begin_info);
-
-            const vk::ClearValue clear_color(vk::ClearColorValue(std::array<float, 4>({ 0.f, 0.f, 0.f, 1.f })));
-            const vk::Rect2D draw_rect({ 0, 0 }, m_extent2D);
-            const vk::RenderPassBeginInfo renderpass_info(m_pipeline.get_renderpass(), 
-                                                          m_framebuffers[i], 
-                                                          draw_rect, 1, 
-                                                         &clear_color);
-
-			m_commandbuffers[i].beginRenderPass(renderpass_info, vk::SubpassContents::eInline);
-			m_commandbuffers[i].bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline.get());
+			i_frame.image_available = m_device.createSemaphore(semaphore_createinfo);
+			i_frame.render_finished = m_device.createSemaphore(semaphore_createinfo);
+		}
 
-            const vk::Buffer     vertex_buffers[] = { m_vertex_buffer.get() };
-            const vk::DeviceSize buffer_offsets[] = { 0 };
-			m_commandbuffers[i].bindVertexBuffers(0, 1, vertex_buffers, buffer_offsets);
-            m_commandbuffers[i].bindIndexBuffer(m_index_buffer.get(), 0, vk::IndexType::eUint16);
+		// Timeline value 0 is retired from the start, so first waits return immediately
+		m_images_in_flight.assign(m_images.size(), 0);
 
-            const uint32_t vertex_array_size = m_vertex_buffer.vertices().size();
-			m_commandbuffers[i].drawIndexed(m_index_buffer.indices().size(), 1, 0, 0, 0);
-			m_commandbuffers[i].endRenderPass();
-			m_commandbuffers[i].end();
-		}
+		log->trace("Created synchronization for {} frames in flight.", m_frames_in_flight);
 	}
 
-	void swapchain::create_commandpool()
+	void swapchain::create_commandpools()
 	{
-		log->trace("Creating Command Pool...");
-
         const queue_families family_indices = find_queue_families(m_physical_device);
 
-        const vk::CommandPoolCreateInfo cmdpool_createinfo({}, family_indices.graphics);
-		m_commandpool = m_device.createCommandPool(cmdpool_createinfo);
+        // The render thread is recording thread 0, its pools also hold the primaries
+		m_commands.init(m_frames_in_flight, m_recorder.thread_count(), family_indices.graphics);
+		m_recorder.init();
 	}
 
 	void swapchain::create_renderpass()
@@ -434,7 +889,9 @@ namespace ppr
         const vk::AttachmentDescription color_attach_descript({}, m_image_format, vk::SampleCountFlagBits::e1,
 			                                                  vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eStore,
 			                                                  vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
-			                                                  vk::ImageLayout::eUndefined, vk::ImageLayout::ePresentSrcKHR);
+			                                                  vk::ImageLayout::eUndefined, 
+                                                              m_config.headless ? vk::ImageLayout::eTransferSrcOptimal 
+                                                                                : vk::ImageLayout::ePresentSrcKHR);
 
         const vk::AttachmentReference color_attach_ref(0, vk::ImageLayout::eColorAttachmentOptimal);
 
@@ -449,6 +906,153 @@ namespace ppr
 
         const vk::RenderPassCreateInfo renderpass_info({}, 1, &color_attach_descript, 1, &subpass, 1, &subpass_dependency);
 
-		m_pipeline.get_renderpass() = m_device.createRenderPass(renderpass_info);
+		m_renderpass = m_device.createRenderPass(renderpass_info);
+	}
+
+	void swapchain::create_pipelines()
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		m_default_pipeline = m_pipelines.request(for_render_pass(pipeline_description()));
+		wait_for_default_pipeline();
+
+		const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		log->info("Default pipeline ready in {:.2f} ms, {} compiler threads ({} pipeline cache at startup).", 
+                  elapsed.count(), m_pipeline_compiler.thread_count(), 
+                  m_pipeline_cache.is_warm() ? "warm" : "cold");
+	}
+
+	void swapchain::create_uniforms()
+	{
+		// Every pipeline binds the same uniform set, its layout is reflected from the default shaders
+		const pipeline_description defaults;
+		const shader_module_ref vert_shader = m_shader_modules.acquire(defaults.vertex_shader, vk::ShaderStageFlagBits::eVertex);
+		const shader_module_ref frag_shader = m_shader_modules.acquire(defaults.fragment_shader, vk::ShaderStageFlagBits::eFragment);
+
+		if (!vert_shader || !frag_shader)
+		{
+			log->critical("Failed to load the default shaders.");
+			return;
+		}
+
+		const auto set_layouts = m_layouts.set_layouts({ &vert_shader->reflection, &frag_shader->reflection });
+
+		// the allocator expects set 0 to be uniform blocks at bindings 0..n-1
+		std::vector<vk::DeviceSize> binding_sizes;
+		for (const shader_reflection* i_stage : { &vert_shader->reflection, &frag_shader->reflection })
+		{
+			for (const auto& i_binding : i_stage->bindings)
+			{
+				if (i_binding.set != 0)
+					continue;
+
+				if (binding_sizes.size() <= i_binding.binding)
+					binding_sizes.resize(i_binding.binding + 1, 0);
+
+				binding_sizes[i_binding.binding] = std::max<vk::DeviceSize>(binding_sizes[i_binding.binding], i_binding.size);
+			}
+		}
+
+		const std::vector<vk::DeviceSize> expected_sizes = { sizeof(frame_uniforms), sizeof(draw_uniforms) };
+
+		if (set_layouts.empty() || binding_sizes != expected_sizes)
+			log->critical("Uniform blocks in the default shaders don't match frame_uniforms and draw_uniforms.");
+
+		m_uniforms.init(m_frames_in_flight, set_layouts.empty() ? vk::DescriptorSetLayout() : set_layouts[0], binding_sizes);
+
+		if (!set_layouts.empty())
+			m_pipelines.set_uniform_layout(set_layouts[0]);
+	}
+
+	void swapchain::prewarm_pipelines()
+	{
+		std::vector<pipeline_description> recorded;
+
+		if (!pipeline_registry::load_usage(PIPELINE_USAGE_PATH, recorded))
+			return;
+
+		// Queued now, they compile on the worker threads while the rest of the
+		// renderer and the scene load, instead of on first use
+		for (const auto& i_description : recorded)
+			m_pipelines.request(for_render_pass(i_description));
+
+		log->info("Prewarming {} pipelines used last session.", recorded.size());
+	}
+
+	void swapchain::wait_for_default_pipeline()
+	{
+		// Only the fallback is waited for, the rest finish in the background
+		const pipeline_handle& fallback = m_pipelines.get(m_default_pipeline);
+		m_pipeline_compiler.wait(fallback);
+
+		if (!fallback->is_ready())
+			log->critical("Failed to create the default graphics pipeline.");
+	}
+
+	pipeline_description swapchain::for_render_pass(pipeline_description a_description) const
+	{
+		a_description.renderpass = m_renderpass;
+		a_description.color_format = m_image_format;
+
+		return a_description;
+	}
+
+	void swapchain::rebuild_pipelines()
+	{
+		// Runs on the watcher thread. Shader compiler and pipeline cache are both safe to
+		// use concurrently, the lock only keeps the render pass and pipeline count stable.
+		std::lock_guard<std::mutex> lock(m_reload_mutex);
+
+		const auto start = std::chrono::steady_clock::now();
+
+		std::vector<pipeline_handle> rebuilt = m_pipelines.compile_all();
+
+		bool succeeded = true;
+		for (const auto& i_pipeline : rebuilt)
+		{
+			m_pipeline_compiler.wait(i_pipeline);
+			succeeded = succeeded && i_pipeline->is_ready();
+		}
+
+		if (!succeeded)
+		{
+			pipeline_registry::discard(rebuilt);
+			log->warn("Shader reload failed, keeping the current pipelines.");
+			return;
+		}
+
+		// A set the render thread has not picked up yet was never used, drop it directly
+		pipeline_registry::discard(m_reloaded_pipelines);
+
+		m_reloaded_pipelines = std::move(rebuilt);
+		m_reloaded_generation = m_pipeline_generation;
+		m_reload_ready = true;
+
+		const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		log->info("Rebuilt {} pipelines in {:.2f} ms.", m_reloaded_pipelines.size(), elapsed.count());
+	}
+
+	void swapchain::swap_reloaded_pipelines()
+	{
+		// Never wait for the worker, the new set is picked up next frame instead
+		std::unique_lock<std::mutex> lock(m_reload_mutex, std::try_to_lock);
+
+		if (!lock.owns_lock())
+			return;
+
+		m_reload_ready = false;
+
+		// Pipelines were retired since the rebuild started (scene load, format change)
+		if (m_reloaded_generation != m_pipeline_generation)
+		{
+			pipeline_registry::discard(m_reloaded_pipelines);
+			return;
+		}
+
+		m_pipelines.replace(m_reloaded_pipelines, m_deletions);
+		++m_pipeline_generation;
+
+		// modules of the edited shaders are no longer referenced by anything
+		m_shader_modules.trim();
 	}
-}
\ No newline at end of file
+}
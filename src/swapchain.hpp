@@ -1,5 +1,6 @@
 #pragma once
 
+#include "globals.hpp"
 #include "vulkan_structs.hpp"
 #include "structs.hpp"
 #include "util.hpp"
@@ -7,11 +8,25 @@
 #include "pipeline.hpp"
 #include "vertex_buffer.hpp"
 #include "index_buffer.hpp"
+#include "timeline.hpp"
+#include "scene.hpp"
+#include "profiler.hpp"
+#include "memory_allocator.hpp"
+#include "staging_ring.hpp"
+#include "upload_batcher.hpp"
+#include "uniform_allocator.hpp"
+#include "deletion_queue.hpp"
+#include "pipeline_cache.hpp"
+#include "shader_watcher.hpp"
+#include "pipeline_registry.hpp"
+#include "command_recorder.hpp"
 
 #include <vulkan/vulkan.hpp>
 
 #include <vector>
 #include <functional>
+#include <atomic>
+#include <mutex>
 
 namespace ppr
 {
@@ -21,12 +36,23 @@ namespace ppr
 		swapchain(const vk::Device& a_device, 
 				const window& a_window,
 				const vk::Instance& an_instance,
-				const vk::PhysicalDevice& a_physical_device);
+				const vk::PhysicalDevice& a_physical_device,
+				memory_allocator& an_allocator,
+				const pipeline_cache& a_pipeline_cache,
+				shader_module_cache& a_shader_modules,
+				pipeline_compiler& a_pipeline_compiler,
+				pipeline_layout_cache& a_layouts,
+				const context_config& a_config);
 		~swapchain();
 
 		void draw();
 		void init();
 
+		// Replaces the geometry, draw list and pipelines. Doesn't wait for the GPU, the
+		// current buffers go to the deletion queue until the frames using them retire.
+		// Returns false and keeps the current scene if a draw's pipeline index is invalid.
+		bool load_scene(const scene& a_scene);
+
 		void create();
 		void recreate();
 
@@ -41,29 +67,88 @@ namespace ppr
 
         vk::Queue& graphics_queue();
         vk::Queue& present_queue();
+        vk::Queue& transfer_queue();
+
+		uint32_t frames_in_flight() const;
+		bool frame_retired(uint64_t a_frame_number);
+
+		timeline& graphics_timeline();
+
+		const profiler_report& frame_report() const;
 
 	private:
+		bool begin_frame(frame_context& a_frame);
+		void record_commands(const frame_context& a_frame);
+		void record_scene(const frame_context& a_frame);
+		void record_draws(const vk::CommandBuffer& a_commandbuffer, const frame_context& a_frame, 
+                          const uniform_allocation& a_frame_uniform, const uniform_allocation& a_draw_uniforms, 
+                          size_t a_begin, size_t a_end) const;
+		void end_frame(const frame_context& a_frame);
+
 		void destroy_window_surface() const;
+		void create_offscreen_images();
 		void create_imageviews();
 		void create_framebuffers();
-		void create_commandpool();
-		void create_commandbuffers();
+		void create_commandpools();
 		void create_renderpass();
-		void create_semaphores();
+		void create_sync_objects();
+		void create_uniforms();
+		void create_pipelines();
+		void prewarm_pipelines();
+		void wait_for_default_pipeline();
+		pipeline_description for_render_pass(pipeline_description a_description) const;
+
+		// Hot reload: the watcher thread builds a full replacement set, the
+		// render thread swaps it in at the start of a frame
+		void rebuild_pipelines();
+		void swap_reloaded_pipelines();
+
+		void retire_swapchain_resources();
 
 		vk::Extent2D choose_extent(const vk::SurfaceCapabilitiesKHR& a_capabilities) const;
 		vk::PresentModeKHR choose_present_mode(const std::vector<vk::PresentModeKHR>& an_available_modes) const;
 		vk::SurfaceFormatKHR choose_surface_format(const std::vector<vk::SurfaceFormatKHR>& an_available_formats) const;
 
 	private:
+		// Per frame-in-flight synchronization and recording state
+		struct frame_resources
+		{
+			vk::Semaphore image_available;
+			vk::Semaphore render_finished;
+
+			uint64_t frame_number = 0;
+			uint64_t submit_value = 0; // graphics timeline value signalled by this slot's last submit
+		};
+
+	private:
+		const context_config& m_config;
 		const window& m_window;
 		const vk::Device& m_device;
 		const vk::Instance& m_instance;
 		const vk::PhysicalDevice& m_physical_device;
+		memory_allocator& m_allocator;
+		const pipeline_cache& m_pipeline_cache;
+		shader_module_cache& m_shader_modules;
+		pipeline_compiler& m_pipeline_compiler;
+		pipeline_layout_cache& m_layouts;
+
+		vk::RenderPass m_renderpass;
+		pipeline_registry m_pipelines;
+		uint32_t m_default_pipeline; // always ready, stands in for pipelines still compiling
+
+		// Held by the reload worker while it builds, and by the render thread whenever it
+		// replaces the render pass or pipelines. begin_frame() only ever try-locks it.
+		std::mutex m_reload_mutex;
+		std::vector<pipeline_handle> m_reloaded_pipelines;
+		uint64_t m_pipeline_generation;  // bumped whenever the pipelines behind the registry's ids change
+		uint64_t m_reloaded_generation;  // generation the reloaded set was built against
+		std::atomic<bool> m_reload_ready;
+		shader_watcher m_shader_watcher;
 
-		pipeline m_pipeline;
 		vertex_buffer m_vertex_buffer;
         index_buffer m_index_buffer;
+		std::vector<draw_call> m_draws;
+		std::vector<uint32_t> m_draw_pipelines; // distinct pipeline ids in m_draws
 
 		vk::SurfaceKHR m_surface;
 		vk::SwapchainKHR m_swapchain;
@@ -73,14 +158,30 @@ namespace ppr
 
 		vk::Queue m_queue_present;
 		vk::Queue m_queue_graphics;
+		vk::Queue m_queue_transfer; // graphics queue when there is no transfer-only family
+
+		timeline m_timeline;
+		timeline m_transfer_timeline; // separate counter even when it shares the graphics queue
+		staging_ring m_staging;
+		upload_batcher m_uploads;
+		uniform_allocator m_uniforms;
 
-		vk::CommandPool m_commandpool;
-		vk::Semaphore m_sema_image_available;
-		vk::Semaphore m_sema_render_finished;
+		command_allocator m_commands;
+		command_recorder m_recorder;
+
+		const uint32_t m_frames_in_flight;
+		uint32_t m_frame_index;
+		uint64_t m_frame_number;
+		std::vector<frame_resources> m_frames;
 
 		std::vector<vk::Image> m_images;
+		std::vector<allocation> m_image_memory; // headless only, swapchain images own their memory
 		std::vector<vk::ImageView> m_image_views;
 		std::vector<vk::Framebuffer> m_framebuffers;
-		std::vector<vk::CommandBuffer> m_commandbuffers;
+		std::vector<uint64_t> m_images_in_flight; // timeline value of the frame last rendering to each image
+
+		deletion_queue m_deletions;
+
+		profiler m_profiler;
 	};
 }
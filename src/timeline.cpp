@@ -0,0 +1,118 @@
+#include "timeline.hpp"
+#include "util.hpp"
+#include "logger.hpp"
+
+namespace ppr
+{
+    timeline::timeline(const vk::Device& a_device, const vk::Queue& a_queue)
+        : m_device(a_device)
+        , m_queue(a_queue)
+        , m_pending_value(0)
+        , m_completed_value(0)
+    {}
+
+    void timeline::destroy()
+    {
+        wait_idle();
+
+        for (auto i_fence : m_free_fences)
+            m_device.destroyFence(i_fence);
+
+        m_free_fences.clear();
+    }
+
+    uint64_t timeline::submit(const vk::SubmitInfo& a_submit_info)
+    {
+        return submit(std::vector<vk::SubmitInfo>{ a_submit_info });
+    }
+
+    uint64_t timeline::submit(const std::vector<vk::SubmitInfo>& a_submit_infos)
+    {
+        const vk::Fence fence = acquire_fence();
+
+        m_queue.submit(a_submit_infos, fence);
+
+        m_submissions.push_back({ ++m_pending_value, fence });
+
+        return m_pending_value;
+    }
+
+    uint64_t timeline::pending_value() const
+    {
+        return m_pending_value;
+    }
+
+    uint64_t timeline::completed_value()
+    {
+        uint64_t last_signaled = m_completed_value;
+
+        for (const auto& i_submission : m_submissions)
+        {
+            if (m_device.getFenceStatus(i_submission.fence) != vk::Result::eSuccess)
+                break;
+
+            last_signaled = i_submission.value;
+        }
+
+        retire_until(last_signaled);
+
+        return m_completed_value;
+    }
+
+    bool timeline::has_retired(uint64_t a_value)
+    {
+        return a_value <= m_completed_value || a_value <= completed_value();
+    }
+
+    void timeline::wait(uint64_t a_value)
+    {
+        if (a_value > m_pending_value)
+            log->critical("Waiting on timeline value {} which was never submitted (last: {}).", a_value, m_pending_value);
+
+        if (a_value <= m_completed_value)
+            return;
+
+        // the first submission at or past the value covers everything before it
+        for (const auto& i_submission : m_submissions)
+        {
+            if (i_submission.value >= a_value)
+            {
+                m_device.waitForFences(i_submission.fence, true, UINT64_MAX);
+                retire_until(i_submission.value);
+                return;
+            }
+        }
+    }
+
+    void timeline::wait_idle()
+    {
+        wait(m_pending_value);
+    }
+
+    vk::Fence timeline::acquire_fence()
+    {
+        if (m_free_fences.empty())
+            return m_device.createFence(vk::FenceCreateInfo());
+
+        const vk::Fence fence = m_free_fences.back();
+        m_free_fences.pop_back();
+
+        return fence;
+    }
+
+    void timeline::retire_until(uint64_t a_value)
+    {
+        while (!m_submissions.empty() && m_submissions.front().value <= a_value)
+        {
+            const vk::Fence fence = m_submissions.front().fence;
+
+            m_device.resetFences(fence);
+            m_free_fences.push_back(fence);
+
+            m_submissions.pop_front();
+        }
+
+        if (a_value > m_completed_value)
+            m_completed_value = a_value;
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <deque>
+#include <vector>
+
+namespace ppr
+{
+    // A monotonically increasing counter of completed work on a single queue.
+    // Every submission made through the timeline is assigned the next value, and
+    // callers wait on or poll values instead of juggling individual fences.
+    //
+    // The bundled Vulkan headers (1.1.82) predate VK_KHR_timeline_semaphore, so
+    // values are backed by a small pool of recycled fences. Fences signalled by
+    // vkQueueSubmit cover all earlier work on the queue, which is what makes a
+    // single counter per queue sound.
+    class timeline
+    {
+    public:
+        timeline(const vk::Device& a_device, const vk::Queue& a_queue);
+
+        void destroy();
+
+        uint64_t submit(const vk::SubmitInfo& a_submit_info);
+        uint64_t submit(const std::vector<vk::SubmitInfo>& a_submit_infos);
+
+        // value of the most recent submission
+        uint64_t pending_value() const;
+        // highest value known to have finished executing on the GPU
+        uint64_t completed_value();
+
+        bool has_retired(uint64_t a_value);
+        void wait(uint64_t a_value);
+        void wait_idle();
+
+    private:
+        vk::Fence acquire_fence();
+        void retire_until(uint64_t a_value);
+
+    private:
+        const vk::Device& m_device;
+        const vk::Queue& m_queue;
+
+        uint64_t m_pending_value;
+        uint64_t m_completed_value;
+
+        struct submission
+        {
+            uint64_t value;
+            vk::Fence fence;
+        };
+
+        std::deque<submission> m_submissions;
+        std::vector<vk::Fence> m_free_fences;
+    };
+}
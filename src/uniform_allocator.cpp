@@ -0,0 +1,162 @@
+#include "uniform_allocator.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+
+namespace ppr
+{
+    constexpr vk::DeviceSize uniform_allocator::DEFAULT_FRAME_CAPACITY;
+
+    uniform_allocator::uniform_allocator(const vk::Device& a_device, 
+                                         const vk::PhysicalDevice& a_physical_device, 
+                                               memory_allocator& an_allocator)
+        : m_device(a_device)
+        , m_physical_device(a_physical_device)
+        , m_buffer(a_device, an_allocator)
+        , m_mapped(nullptr)
+        , m_frames_in_flight(0)
+        , m_alignment(1)
+        , m_frame_capacity(0)
+        , m_frame_begin(0)
+        , m_head(0)
+    {}
+
+    void uniform_allocator::init(uint32_t a_frames_in_flight, 
+                                 const vk::DescriptorSetLayout& a_set_layout, 
+                                 const std::vector<vk::DeviceSize>& a_binding_sizes, 
+                                 vk::DeviceSize a_frame_capacity)
+    {
+        log->trace("Creating uniform allocator...");
+
+        m_alignment = std::max<vk::DeviceSize>(1, m_physical_device.getProperties().limits.minUniformBufferOffsetAlignment);
+        m_frames_in_flight = a_frames_in_flight;
+        m_binding_sizes = a_binding_sizes;
+        m_set_layout = a_set_layout;
+
+        create_buffer(a_frame_capacity);
+        create_descriptors();
+
+        log->trace("Created uniform allocator with {} KiB per frame, {} byte alignment.", 
+                   m_frame_capacity / 1024, m_alignment);
+    }
+
+    void uniform_allocator::destroy()
+    {
+        // Freeing the pool frees the set allocated from it
+        m_device.destroyDescriptorPool(m_descriptor_pool);
+
+        m_buffer.destroy();
+        m_mapped = nullptr;
+    }
+
+    void uniform_allocator::reserve(vk::DeviceSize a_frame_capacity, deletion_queue& a_deletions)
+    {
+        if (a_frame_capacity <= m_frame_capacity)
+            return;
+
+        log->debug("Growing uniform frame slices from {} KiB to {} KiB.", 
+                   m_frame_capacity / 1024, (a_frame_capacity + 1023) / 1024);
+
+        // Freeing the pool frees the set allocated from it
+        a_deletions.destroy(m_descriptor_pool);
+        m_buffer.destroy(a_deletions);
+
+        create_buffer(a_frame_capacity);
+        create_descriptors();
+
+        m_frame_begin = 0;
+        m_head = 0;
+    }
+
+    void uniform_allocator::begin_frame(uint32_t a_frame_index)
+    {
+        m_frame_begin = m_frame_capacity * a_frame_index;
+        m_head = m_frame_begin;
+    }
+
+    uniform_allocation uniform_allocator::allocate(vk::DeviceSize a_size)
+    {
+        const vk::DeviceSize offset = (m_head + m_alignment - 1) / m_alignment * m_alignment;
+
+        if (offset + a_size > m_frame_begin + m_frame_capacity)
+        {
+            log->critical("Uniform allocator ran out of its {} KiB frame slice.", m_frame_capacity / 1024);
+            return uniform_allocation();
+        }
+
+        m_head = offset + a_size;
+
+        uniform_allocation allocation;
+        allocation.data = m_mapped + offset;
+        allocation.dynamic_offset = static_cast<uint32_t>(offset);
+        allocation.size = a_size;
+
+        return allocation;
+    }
+
+    vk::DeviceSize uniform_allocator::stride(vk::DeviceSize a_size) const
+    {
+        return (a_size + m_alignment - 1) / m_alignment * m_alignment;
+    }
+
+    const vk::DescriptorSetLayout& uniform_allocator::descriptor_layout() const
+    {
+        return m_set_layout;
+    }
+
+    const vk::DescriptorSet& uniform_allocator::descriptor_set() const
+    {
+        return m_set;
+    }
+
+    vk::DeviceSize uniform_allocator::frame_usage() const
+    {
+        return m_head - m_frame_begin;
+    }
+
+    void uniform_allocator::create_buffer(vk::DeviceSize a_frame_capacity)
+    {
+        // keep every slice aligned so offsets computed within one stay aligned
+        m_frame_capacity = (a_frame_capacity + m_alignment - 1) / m_alignment * m_alignment;
+
+        const vk::DeviceSize size = m_frame_capacity * m_frames_in_flight;
+
+        // Dynamic offsets are 32 bits
+        if (size > UINT32_MAX)
+            log->critical("Uniform buffer of {} MiB exceeds the dynamic offset range.", size / (1024 * 1024));
+
+        const vk::BufferCreateInfo buffer_info({}, size, vk::BufferUsageFlagBits::eUniformBuffer);
+
+        // Rewritten every frame, so worth a slot in the BAR window when there is room
+        if (!m_buffer.try_create_direct_write(buffer_info))
+        {
+            m_buffer.create(buffer_info, vk::MemoryPropertyFlagBits::eHostVisible 
+                                       | vk::MemoryPropertyFlagBits::eHostCoherent);
+        }
+        m_mapped = static_cast<char*>(m_buffer.mapped());
+    }
+
+    void uniform_allocator::create_descriptors()
+    {
+        const uint32_t binding_count = static_cast<uint32_t>(m_binding_sizes.size());
+
+        const vk::DescriptorPoolSize pool_size(vk::DescriptorType::eUniformBufferDynamic, binding_count);
+        m_descriptor_pool = m_device.createDescriptorPool(vk::DescriptorPoolCreateInfo({}, 1, 1, &pool_size));
+
+        m_set = m_device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(m_descriptor_pool, 1, &m_set_layout)).at(0);
+
+        // Every binding views the same buffer, the dynamic offset picks the range at bind time
+        std::vector<vk::DescriptorBufferInfo> buffer_infos;
+        for (const auto i_size : m_binding_sizes)
+            buffer_infos.emplace_back(m_buffer.get(), 0, i_size);
+
+        std::vector<vk::WriteDescriptorSet> writes;
+        for (uint32_t i = 0; i < binding_count; ++i)
+        {
+            writes.emplace_back(m_set, i, 0, 1, vk::DescriptorType::eUniformBufferDynamic, 
+                                nullptr, &buffer_infos[i], nullptr);
+        }
+
+        m_device.updateDescriptorSets(writes, nullptr);
+    }
+}
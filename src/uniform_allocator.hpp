@@ -0,0 +1,103 @@
+#pragma once
+
+#include "buffer.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <vector>
+#include <cstring>
+
+namespace ppr
+{
+    // A range handed out by uniform_allocator, valid until its frame slot comes around again
+    struct uniform_allocation
+    {
+        void* data = nullptr;
+        uint32_t dynamic_offset = 0;
+        vk::DeviceSize size = 0;
+
+        explicit operator bool() const
+        { return data != nullptr; }
+    };
+
+    // Per-frame bump allocator for uniform data. A single persistently mapped
+    // buffer is split into one slice per frame in flight. Each allocation bumps
+    // a pointer within the current frame's slice, and the slice is reset
+    // wholesale when its frame slot is reused. Allocations are bound through
+    // one descriptor set of dynamic uniform buffers, so per-draw data costs a
+    // dynamic offset rather than a buffer or descriptor set of its own.
+    class uniform_allocator
+    {
+    public:
+        uniform_allocator(const vk::Device& a_device, 
+                          const vk::PhysicalDevice& a_physical_device, 
+                                memory_allocator& an_allocator);
+
+        // a_set_layout declares one dynamic uniform buffer per binding (it is not
+        // owned), a_binding_sizes holds the size of the struct each of them sees
+        void init(uint32_t a_frames_in_flight, 
+                  const vk::DescriptorSetLayout& a_set_layout, 
+                  const std::vector<vk::DeviceSize>& a_binding_sizes, 
+                  vk::DeviceSize a_frame_capacity = DEFAULT_FRAME_CAPACITY);
+        void destroy();
+
+        // Grows every frame slice to at least a_frame_capacity. The old buffer and
+        // descriptor set may still be in use by frames in flight, so they go to
+        // a_deletions. Call between frames, allocations made before are invalidated.
+        void reserve(vk::DeviceSize a_frame_capacity, deletion_queue& a_deletions);
+
+        // The caller must have waited for the previous use of this frame slot
+        void begin_frame(uint32_t a_frame_index);
+
+        uniform_allocation allocate(vk::DeviceSize a_size);
+
+        // Distance between consecutive allocations of a_size. An allocation of
+        // a_count strides holds a_count values that can each be bound on their own.
+        vk::DeviceSize stride(vk::DeviceSize a_size) const;
+
+        template<typename T>
+        uniform_allocation push(const T& a_data);
+
+        const vk::DescriptorSetLayout& descriptor_layout() const;
+        const vk::DescriptorSet& descriptor_set() const;
+
+        vk::DeviceSize frame_usage() const;
+
+    public:
+        static constexpr vk::DeviceSize DEFAULT_FRAME_CAPACITY = 4ull * 1024 * 1024;
+
+    private:
+        void create_buffer(vk::DeviceSize a_frame_capacity);
+        void create_descriptors();
+
+    private:
+        const vk::Device& m_device;
+        const vk::PhysicalDevice& m_physical_device;
+
+        buffer m_buffer;
+        char* m_mapped;
+
+        uint32_t m_frames_in_flight;
+        std::vector<vk::DeviceSize> m_binding_sizes;
+
+        vk::DeviceSize m_alignment; // minUniformBufferOffsetAlignment
+        vk::DeviceSize m_frame_capacity;
+        vk::DeviceSize m_frame_begin;
+        vk::DeviceSize m_head;
+
+        vk::DescriptorSetLayout m_set_layout;
+        vk::DescriptorPool m_descriptor_pool;
+        vk::DescriptorSet m_set;
+    };
+
+    template<typename T>
+    uniform_allocation uniform_allocator::push(const T& a_data)
+    {
+        const uniform_allocation allocation = allocate(sizeof(T));
+
+        if (allocation)
+            memcpy(allocation.data, &a_data, sizeof(T));
+
+        return allocation;
+    }
+}
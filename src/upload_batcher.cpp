@@ -0,0 +1,334 @@
+#include "upload_batcher.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+
+namespace ppr
+{
+    namespace
+    {
+        const vk::AccessFlags READ_ACCESS = vk::AccessFlagBits::eVertexAttributeRead
+                                          | vk::AccessFlagBits::eIndexRead
+                                          | vk::AccessFlagBits::eUniformRead
+                                          | vk::AccessFlagBits::eShaderRead;
+
+        const vk::PipelineStageFlags READ_STAGES = vk::PipelineStageFlagBits::eVertexInput 
+                                                 | vk::PipelineStageFlagBits::eVertexShader 
+                                                 | vk::PipelineStageFlagBits::eFragmentShader;
+    }
+
+    upload_batcher::upload_batcher(const vk::Device& a_device, 
+                                         timeline& a_transfer_timeline, 
+                                         timeline& a_graphics_timeline, 
+                                         staging_ring& a_staging)
+        : m_device(a_device)
+        , m_transfer_timeline(a_transfer_timeline)
+        , m_graphics_timeline(a_graphics_timeline)
+        , m_staging(a_staging)
+        , m_transfer_family(0)
+        , m_graphics_family(0)
+        , m_dedicated(false)
+        , m_pending_copies(0)
+        , m_batch(1)
+        , m_retired_batch(0)
+    {}
+
+    void upload_batcher::init(uint32_t a_transfer_family, uint32_t a_graphics_family)
+    {
+        log->trace("Creating upload batcher...");
+
+        m_transfer_family = a_transfer_family;
+        m_graphics_family = a_graphics_family;
+        m_dedicated = a_transfer_family != a_graphics_family;
+
+        const vk::CommandPoolCreateFlags pool_flags = vk::CommandPoolCreateFlagBits::eTransient 
+                                                    | vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+
+        m_commandpool = m_device.createCommandPool(vk::CommandPoolCreateInfo(pool_flags, a_transfer_family));
+
+        if (m_dedicated)
+            m_acquire_commandpool = m_device.createCommandPool(vk::CommandPoolCreateInfo(pool_flags, a_graphics_family));
+
+        if (m_dedicated)
+            log->debug("Uploads run on dedicated transfer queue family {}.", a_transfer_family);
+        else
+            log->debug("No dedicated transfer queue family, uploads share the graphics queue.");
+    }
+
+    void upload_batcher::destroy()
+    {
+        if (m_pending_copies > 0)
+            log->warn("Destroying upload batcher with {} copies never submitted.", m_pending_copies);
+
+        for (const auto& i_batch : m_submitted)
+        {
+            if (i_batch.semaphore)
+                m_device.destroySemaphore(i_batch.semaphore);
+        }
+
+        for (auto i_semaphore : m_free_semaphores)
+            m_device.destroySemaphore(i_semaphore);
+
+        // Freeing the pool frees every command buffer allocated from it
+        m_device.destroyCommandPool(m_commandpool);
+
+        if (m_acquire_commandpool)
+            m_device.destroyCommandPool(m_acquire_commandpool);
+
+        m_recording = nullptr;
+        m_ownership_barriers.clear();
+        m_submitted.clear();
+        m_free_commandbuffers.clear();
+        m_free_acquire_commandbuffers.clear();
+        m_free_semaphores.clear();
+    }
+
+    upload_ticket upload_batcher::enqueue(const buffer& a_dst, const void* a_data, vk::DeviceSize a_size, vk::DeviceSize a_dst_offset)
+    {
+        // Uploads larger than a batch may stage go in pieces, each flushed before the next
+        const vk::DeviceSize max_copy = std::max<vk::DeviceSize>(1, m_staging.capacity() / 2);
+        const char* data = static_cast<const char*>(a_data);
+
+        for (vk::DeviceSize i_offset = 0; i_offset < a_size; i_offset += max_copy)
+        {
+            if (!record_copy(a_dst, data + i_offset, std::min(max_copy, a_size - i_offset), a_dst_offset + i_offset))
+                break;
+        }
+
+        upload_ticket ticket;
+        ticket.batch = m_batch;
+        return ticket;
+    }
+
+    bool upload_batcher::record_copy(const buffer& a_dst, const void* a_data, vk::DeviceSize a_size, vk::DeviceSize a_dst_offset)
+    {
+        // Don't let one batch hog the ring, older batches can only be recycled once submitted
+        if (m_staging.pending_size() + a_size > m_staging.capacity() / 2)
+            flush();
+
+        staging_region staging = m_staging.write(a_data, a_size);
+
+        // The ring only waits on submitted copies, wrap padding can leave it full of this batch's
+        if (!staging && m_staging.pending_size() > 0)
+        {
+            flush();
+            staging = m_staging.write(a_data, a_size);
+        }
+
+        if (!staging)
+        {
+            log->error("Dropped an upload of {} bytes, no staging space.", a_size);
+            return false;
+        }
+
+        if (!m_recording)
+            m_recording = acquire_commandbuffer(m_free_commandbuffers, m_commandpool);
+
+        const auto copy_region = vk::BufferCopy()
+                                        .setSrcOffset(staging.offset)
+                                        .setDstOffset(a_dst_offset)
+                                        .setSize(a_size);
+        m_recording.copyBuffer(m_staging.source().get(), a_dst.get(), copy_region);
+
+        if (m_dedicated)
+        {
+            // Exclusive buffers have to change hands before the graphics queue may read them
+            m_ownership_barriers.push_back(vk::BufferMemoryBarrier()
+                                                .setSrcQueueFamilyIndex(m_transfer_family)
+                                                .setDstQueueFamilyIndex(m_graphics_family)
+                                                .setBuffer(a_dst.get())
+                                                .setOffset(a_dst_offset)
+                                                .setSize(a_size));
+        }
+
+        ++m_pending_copies;
+
+        return true;
+    }
+
+    uint64_t upload_batcher::flush()
+    {
+        if (!m_recording)
+            return m_submitted.empty() ? 0 : m_submitted.back().transfer_value;
+
+        submitted_batch batch = {};
+        batch.batch = m_batch;
+        batch.commandbuffer = m_recording;
+
+        auto submit_info = vk::SubmitInfo()
+                           .setCommandBufferCount(1)
+                           .setPCommandBuffers(&m_recording);
+
+        if (m_dedicated)
+        {
+            // Release half of the ownership transfer, access masks are ignored here
+            for (auto& i_barrier : m_ownership_barriers)
+                i_barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+                         .setDstAccessMask({});
+
+            m_recording.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, 
+                                        vk::PipelineStageFlagBits::eBottomOfPipe, 
+                                        {}, nullptr, m_ownership_barriers, nullptr);
+
+            batch.semaphore = acquire_semaphore();
+            submit_info.setSignalSemaphoreCount(1)
+                       .setPSignalSemaphores(&batch.semaphore);
+        }
+        else
+        {
+            const auto barrier = vk::MemoryBarrier()
+                                        .setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+                                        .setDstAccessMask(READ_ACCESS);
+            m_recording.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, READ_STAGES, 
+                                        {}, barrier, nullptr, nullptr);
+        }
+
+        m_recording.end();
+
+        batch.transfer_value = m_transfer_timeline.submit(submit_info);
+        m_staging.submitted(batch.transfer_value);
+
+        if (m_dedicated)
+        {
+            batch.acquire_commandbuffer = acquire_commandbuffer(m_free_acquire_commandbuffers, m_acquire_commandpool);
+            submit_acquire(batch.acquire_commandbuffer, batch.semaphore);
+            batch.graphics_value = m_graphics_timeline.pending_value();
+        }
+
+        m_submitted.push_back(batch);
+
+        log->trace("Submitted upload batch {} with {} copies.", m_batch, m_pending_copies);
+
+        m_recording = nullptr;
+        m_ownership_barriers.clear();
+        m_pending_copies = 0;
+        ++m_batch;
+
+        return batch.transfer_value;
+    }
+
+    bool upload_batcher::is_complete(const upload_ticket& a_ticket)
+    {
+        if (a_ticket.batch <= m_retired_batch)
+            return true;
+        if (a_ticket.batch == m_batch)
+            return false;
+
+        retire();
+
+        return a_ticket.batch <= m_retired_batch;
+    }
+
+    void upload_batcher::wait(const upload_ticket& a_ticket)
+    {
+        if (a_ticket.batch == m_batch)
+            flush();
+
+        for (const auto& i_batch : m_submitted)
+        {
+            if (i_batch.batch == a_ticket.batch)
+            {
+                m_transfer_timeline.wait(i_batch.transfer_value);
+                m_graphics_timeline.wait(i_batch.graphics_value);
+                break;
+            }
+        }
+
+        retire();
+    }
+
+    size_t upload_batcher::pending_copies() const
+    {
+        return m_pending_copies;
+    }
+
+    bool upload_batcher::dedicated_queue() const
+    {
+        return m_dedicated;
+    }
+
+    void upload_batcher::retire()
+    {
+        const uint64_t transfer_completed = m_transfer_timeline.completed_value();
+        const uint64_t graphics_completed = m_graphics_timeline.completed_value();
+
+        // A batch is only done once the graphics queue has acquired its buffers too
+        while (!m_submitted.empty() 
+            && m_submitted.front().transfer_value <= transfer_completed
+            && m_submitted.front().graphics_value <= graphics_completed)
+        {
+            const submitted_batch& front = m_submitted.front();
+
+            m_retired_batch = front.batch;
+            m_free_commandbuffers.push_back(front.commandbuffer);
+
+            if (front.acquire_commandbuffer)
+                m_free_acquire_commandbuffers.push_back(front.acquire_commandbuffer);
+            if (front.semaphore)
+                m_free_semaphores.push_back(front.semaphore);
+
+            m_submitted.pop_front();
+        }
+    }
+
+    void upload_batcher::submit_acquire(const vk::CommandBuffer& a_cmd, const vk::Semaphore& a_semaphore)
+    {
+        // Acquire half of the ownership transfer, matching the release recorded on the transfer queue
+        for (auto& i_barrier : m_ownership_barriers)
+            i_barrier.setSrcAccessMask({})
+                     .setDstAccessMask(READ_ACCESS);
+
+        a_cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, READ_STAGES, 
+                              {}, nullptr, m_ownership_barriers, nullptr);
+        a_cmd.end();
+
+        const vk::PipelineStageFlags wait_stage = READ_STAGES;
+        const auto submit_info = vk::SubmitInfo()
+                                 .setWaitSemaphoreCount(1)
+                                 .setPWaitSemaphores(&a_semaphore)
+                                 .setPWaitDstStageMask(&wait_stage)
+                                 .setCommandBufferCount(1)
+                                 .setPCommandBuffers(&a_cmd);
+        m_graphics_timeline.submit(submit_info);
+    }
+
+    vk::CommandBuffer upload_batcher::acquire_commandbuffer(std::vector<vk::CommandBuffer>& a_free, const vk::CommandPool& a_pool)
+    {
+        retire();
+
+        vk::CommandBuffer cmd;
+
+        if (!a_free.empty())
+        {
+            cmd = a_free.back();
+            a_free.pop_back();
+
+            cmd.reset({});
+        }
+        else
+        {
+            const auto alloc_info = vk::CommandBufferAllocateInfo()
+                                               .setLevel(vk::CommandBufferLevel::ePrimary)
+                                               .setCommandPool(a_pool)
+                                               .setCommandBufferCount(1);
+            cmd = m_device.allocateCommandBuffers(alloc_info).at(0);
+        }
+
+        const auto begin_info = vk::CommandBufferBeginInfo()
+                                .setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+        cmd.begin(begin_info);
+
+        return cmd;
+    }
+
+    vk::Semaphore upload_batcher::acquire_semaphore()
+    {
+        if (m_free_semaphores.empty())
+            return m_device.createSemaphore(vk::SemaphoreCreateInfo());
+
+        const vk::Semaphore semaphore = m_free_semaphores.back();
+        m_free_semaphores.pop_back();
+
+        return semaphore;
+    }
+}
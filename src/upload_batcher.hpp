@@ -0,0 +1,96 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "staging_ring.hpp"
+#include "timeline.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <deque>
+#include <vector>
+
+namespace ppr
+{
+    // Handle to a queued upload. Completes when the batch it was recorded into
+    // has executed on the GPU.
+    struct upload_ticket
+    {
+        uint64_t batch = 0;
+    };
+
+    // Records many buffer uploads into one command buffer and submits them
+    // together, once per frame or on an explicit flush, instead of one
+    // submit-and-wait per copy. Data is staged through the staging ring.
+    //
+    // Copies run on the transfer timeline. With a dedicated transfer family the
+    // destination buffers are released to the graphics family at the end of each
+    // batch, and a small acquire submission on the graphics queue waits on the
+    // batch's semaphore. Without one, both timelines sit on the graphics queue
+    // and a plain memory barrier makes the copies visible.
+    class upload_batcher
+    {
+    public:
+        upload_batcher(const vk::Device& a_device, 
+                             timeline& a_transfer_timeline, 
+                             timeline& a_graphics_timeline, 
+                             staging_ring& a_staging);
+
+        void init(uint32_t a_transfer_family, uint32_t a_graphics_family);
+        void destroy();
+
+        upload_ticket enqueue(const buffer& a_dst, const void* a_data, vk::DeviceSize a_size, vk::DeviceSize a_dst_offset = 0);
+
+        // Submit everything queued so far, returns the batch's transfer timeline value
+        uint64_t flush();
+
+        bool is_complete(const upload_ticket& a_ticket);
+        void wait(const upload_ticket& a_ticket);
+
+        size_t pending_copies() const;
+        bool dedicated_queue() const;
+
+    private:
+        // Stages and records one copy, false if no staging space could be found
+        bool record_copy(const buffer& a_dst, const void* a_data, vk::DeviceSize a_size, vk::DeviceSize a_dst_offset);
+
+        void retire();
+        void submit_acquire(const vk::CommandBuffer& a_cmd, const vk::Semaphore& a_semaphore);
+
+        vk::CommandBuffer acquire_commandbuffer(std::vector<vk::CommandBuffer>& a_free, const vk::CommandPool& a_pool);
+        vk::Semaphore acquire_semaphore();
+
+    private:
+        const vk::Device& m_device;
+        timeline& m_transfer_timeline;
+        timeline& m_graphics_timeline;
+        staging_ring& m_staging;
+
+        uint32_t m_transfer_family;
+        uint32_t m_graphics_family;
+        bool m_dedicated;
+
+        vk::CommandPool m_commandpool;
+        vk::CommandPool m_acquire_commandpool; // graphics family, dedicated queue only
+
+        vk::CommandBuffer m_recording;
+        std::vector<vk::BufferMemoryBarrier> m_ownership_barriers;
+        size_t m_pending_copies;
+        uint64_t m_batch; // batch currently being recorded
+
+        struct submitted_batch
+        {
+            uint64_t batch;
+            uint64_t transfer_value;
+            uint64_t graphics_value; // acquire submission, 0 without a dedicated queue
+            vk::CommandBuffer commandbuffer;
+            vk::CommandBuffer acquire_commandbuffer;
+            vk::Semaphore semaphore;
+        };
+
+        std::deque<submitted_batch> m_submitted;
+        std::vector<vk::CommandBuffer> m_free_commandbuffers;
+        std::vector<vk::CommandBuffer> m_free_acquire_commandbuffers;
+        std::vector<vk::Semaphore> m_free_semaphores;
+        uint64_t m_retired_batch; // every batch up to this one has completed
+    };
+}
@@ -4,6 +4,15 @@
 #include <vulkan\vulkan.hpp>
 
 #include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 
 namespace ppr
 {
@@ -37,6 +46,79 @@ namespace ppr
             static_cast<int(*)(int)>(std::tolower));
     }
 
+    uint64_t hash_bytes(const void* a_data, size_t a_size, uint64_t a_seed)
+    {
+        const auto bytes = static_cast<const unsigned char*>(a_data);
+
+        uint64_t hash = a_seed;
+        for (size_t i = 0; i < a_size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    uint64_t hash_string(const std::string& a_string, uint64_t a_seed)
+    {
+        // hash the length too, so "ab" + "c" and "a" + "bc" differ when chained
+        const uint64_t size = a_string.size();
+        return hash_bytes(a_string.data(), a_string.size(), hash_bytes(&size, sizeof(size), a_seed));
+    }
+
+    std::string to_hex(uint64_t a_value)
+    {
+        char text[17];
+        snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(a_value));
+        return text;
+    }
+
+    bool read_file(const std::string& a_path, std::vector<char>& a_contents)
+    {
+        // open file at its end to know the filesize
+        std::ifstream file(a_path, std::ios::ate | std::ios::binary);
+
+        if (!file.is_open())
+            return false;
+
+        a_contents.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(a_contents.data(), a_contents.size());
+
+        return file.good();
+    }
+
+    bool write_file(const std::string& a_path, const void* a_data, size_t a_size)
+    {
+        // write next to the target and swap it in, a crash mid-write must not leave a torn file
+        const std::string temp_path = a_path + ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+
+            if (!file.is_open())
+                return false;
+
+            file.write(static_cast<const char*>(a_data), a_size);
+
+            if (!file.good())
+                return false;
+        }
+
+        std::remove(a_path.c_str());
+        return std::rename(temp_path.c_str(), a_path.c_str()) == 0;
+    }
+
+    bool make_directory(const std::string& a_path)
+    {
+#ifdef _WIN32
+        const int result = _mkdir(a_path.c_str());
+#else
+        const int result = mkdir(a_path.c_str(), 0755);
+#endif
+        return result == 0 || errno == EEXIST;
+    }
+
 	void print(const std::string& aText)
 	{
         log->debug("VkResult: {}", aText);
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 enum VkResult;
 
@@ -17,6 +19,17 @@ namespace ppr
 
     std::string to_lower_copy(std::string a_string);
     void to_lower(std::string& a_string);
+
+    // 64-bit FNV-1a, chain calls by passing the previous hash as a_seed
+    constexpr uint64_t HASH_SEED = 14695981039346656037ull;
+    uint64_t hash_bytes(const void* a_data, size_t a_size, uint64_t a_seed = HASH_SEED);
+    uint64_t hash_string(const std::string& a_string, uint64_t a_seed = HASH_SEED);
+
+    std::string to_hex(uint64_t a_value);
+
+    bool read_file(const std::string& a_path, std::vector<char>& a_contents);
+    bool write_file(const std::string& a_path, const void* a_data, size_t a_size);
+    bool make_directory(const std::string& a_path);
 }
 
 namespace ppr
@@ -18,9 +18,9 @@ namespace ppr
         {}
         const glm::vec2 position;
         const glm::vec3 color;
-
-    public:
-        static const vk::VertexInputBindingDescription binding_descript();
-        static const std::array<vk::VertexInputAttributeDescription, 2> attribute_descript();
     };
+
+    // Pipelines reflect vertex input from shader.vert as tightly packed attributes
+    // in location order, which only matches this struct as long as it has no padding
+    static_assert(sizeof(vertex) == sizeof(glm::vec2) + sizeof(glm::vec3), "vertex must be tightly packed");
 }
\ No newline at end of file
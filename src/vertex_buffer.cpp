@@ -4,9 +4,9 @@
 
 namespace ppr
 {
-	vertex_buffer::vertex_buffer(const vk::Device& a_device) 
+	vertex_buffer::vertex_buffer(const vk::Device& a_device, memory_allocator& an_allocator) 
         : m_device(a_device)
-        , m_buffer(a_device)
+        , m_buffer(a_device, an_allocator)
 	{
 		m_vertices.emplace_back(vertex({{ -0.5f, -0.5f }, { 1.0f, 0.0f, 0.0f }}));
 		m_vertices.emplace_back(vertex({{ 0.5f, -0.5f }, { 0.0f, 1.0f, 0.0f }}));
@@ -14,46 +14,49 @@ namespace ppr
         m_vertices.emplace_back(vertex({{ -0.5f, 0.5f }, { 1.0f, 1.0f, 1.0f }}));        
 	}
 
-    void vertex_buffer::create(const vk::PhysicalDevice& a_physical_device,
-                               const vk::CommandPool& a_command_pool,
-                               const vk::Queue& a_graphics_queue)
+    upload_ticket vertex_buffer::create(upload_batcher& a_uploads)
     {
         const vk::DeviceSize buffer_size = sizeof(m_vertices[0]) * m_vertices.size();
 
-        buffer staging_buffer(m_device);
-        auto staging_buffer_info = buffer::create_info(a_physical_device, 
-                                                       vk::MemoryPropertyFlagBits::eHostVisible
-                                                       | vk::MemoryPropertyFlagBits::eHostCoherent,
-                                                       vk::BufferUsageFlagBits::eTransferSrc,
-                                                       buffer_size);
-        staging_buffer.create(staging_buffer_info);
+        // UMA and ReBAR memory is written in place, skipping the staging copy altogether
+        if (m_buffer.try_create_direct_write(vk::BufferCreateInfo({}, buffer_size, vk::BufferUsageFlagBits::eVertexBuffer)))
+        {
+            memcpy(m_buffer.mapped(), m_vertices.data(), buffer_size);
 
-        auto memory_map = m_device.mapMemory(staging_buffer.memory(), 0, staging_buffer_info.data.size);
-            memcpy(memory_map, m_vertices.data(), staging_buffer_info.data.size);
-        m_device.unmapMemory(staging_buffer.memory());
+            // host writes before the next submission are visible to it, nothing to wait on
+            return upload_ticket();
+        }
 
-        auto vertex_buffer_info = buffer::create_info(a_physical_device, 
-                                                      vk::MemoryPropertyFlagBits::eDeviceLocal,
+        auto vertex_buffer_info = buffer::create_info(vk::MemoryPropertyFlagBits::eDeviceLocal,
                                                       vk::BufferUsageFlagBits::eTransferDst
                                                       | vk::BufferUsageFlagBits::eVertexBuffer,
                                                       buffer_size);
         m_buffer.create(vertex_buffer_info);
 
-        auto buffer_copy_data = buffer::copy_data(m_buffer, 
-                                                  nullptr, 
-                                                  buffer_size, 
-                                                  a_command_pool, 
-                                                  a_graphics_queue);
-        staging_buffer.copy(buffer_copy_data);
-
-        staging_buffer.destroy();
+        // lands in the next upload batch, submitted ahead of the frame that draws with it
+        return a_uploads.enqueue(m_buffer, m_vertices.data(), buffer_size);
     }
 
-    void vertex_buffer::destroy() const
+    void vertex_buffer::destroy()
     {
         m_buffer.destroy();
     }
 
+    void vertex_buffer::destroy(deletion_queue& a_deletions)
+    {
+        m_buffer.destroy(a_deletions);
+    }
+
+    void vertex_buffer::set_vertices(const std::vector<vertex>& a_vertices)
+    {
+        // vertex members are const, so the vector can't be assigned to
+        m_vertices.clear();
+        m_vertices.reserve(a_vertices.size());
+
+        for (const auto& i_vertex : a_vertices)
+            m_vertices.push_back(i_vertex);
+    }
+
     const vk::Buffer& vertex_buffer::get() const
     {
         return m_buffer.get();
@@ -1,6 +1,7 @@
 #pragma once
 #include "vertex.hpp"
 #include "buffer.hpp"
+#include "upload_batcher.hpp"
 
 #include <vulkan/vulkan.hpp>
 
@@ -11,13 +12,14 @@ namespace ppr
 	class vertex_buffer
 	{
 	public:
-		explicit vertex_buffer(const vk::Device& a_physical_device);
+		vertex_buffer(const vk::Device& a_device, memory_allocator& an_allocator);
 
-		void create(const vk::PhysicalDevice& a_physical_device,
-                    const vk::CommandPool& a_command_pool,
-                    const vk::Queue& a_graphics_queue);
+		upload_ticket create(upload_batcher& a_uploads);
 
-		void destroy() const;
+		void destroy();
+		void destroy(deletion_queue& a_deletions);
+
+        void set_vertices(const std::vector<vertex>& a_vertices);
 
         vk::Buffer& get_mut();
         const vk::Buffer& get() const;
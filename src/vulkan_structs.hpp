@@ -15,4 +15,20 @@ namespace ppr
 		std::vector<vk::SurfaceFormatKHR> formats;
 		std::vector<vk::PresentModeKHR> present_modes;
 	};
+
+	// Everything recording code needs to know about the frame it is recording.
+	// Handed out by swapchain for the duration of a single draw() call.
+	struct frame_context
+	{
+		uint32_t index;          // frame-in-flight slot, [0, frames in flight)
+		uint32_t image_index;    // acquired swapchain image
+		uint64_t number;         // monotonically increasing frame counter
+
+		vk::CommandBuffer commandbuffer;
+		vk::Framebuffer framebuffer;
+		vk::Extent2D extent;
+
+		vk::Semaphore image_available;
+		vk::Semaphore render_finished;
+	};
 }
\ No newline at end of file
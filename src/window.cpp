@@ -16,6 +16,19 @@ namespace ppr
 		, m_default_width(a_width)
 		, m_default_height(a_height)
 		, m_title(a_title.c_str())
+	{}
+
+	window::~window()
+	{
+		destroy();
+	}
+
+	bool window::should_close() const
+	{
+		return glfwWindowShouldClose(m_window);
+	}
+
+	void window::init()
 	{
         log->info("Setting up window...");
 
@@ -34,21 +47,6 @@ namespace ppr
         log->info("Window successfully created.\n");
     }
 
-	window::~window()
-	{
-		destroy();
-	}
-
-	bool window::should_close() const
-	{
-		return glfwWindowShouldClose(m_window);
-	}
-
-	void window::init()
-	{
-
-	}
-
 	void window::destroy()
 	{
 		if (m_window != nullptr)